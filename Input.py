@@ -1,4 +1,8 @@
 import subprocess
+try:
+    import schedsim  # built with `make python`; lab6 is used when it is missing
+except ImportError:
+    schedsim = None
 from PyQt6.QtWidgets import (
     QWidget, QLabel, QPushButton, QVBoxLayout, QHBoxLayout,
     QComboBox, QSpinBox, QLineEdit, QTextEdit
@@ -49,7 +53,8 @@ class InputWindow(QWidget):
         self.policy_box = QComboBox()
         self.policy_box.addItems([
             "1 — FCFS", "2 — RR", "3 — SPN", "4 — SRT",
-            "5 — HRRN", "6 — FB-1", "7 — FB-2i", "8 — Aging"
+            "5 — HRRN", "6 — FB-1", "7 — FB-2i", "8 — Aging", "9 — ARR",
+            "10 — PRIO", "11 — O1"
         ])
 
         self.sim_end_spin = QSpinBox()
@@ -67,6 +72,10 @@ class InputWindow(QWidget):
         self.duration_spin = QSpinBox()
         self.duration_spin.setRange(1, 100)
 
+        # Only read by the priority policies (10 and 11)
+        self.priority_spin = QSpinBox()
+        self.priority_spin.setRange(0, 63)
+
         self.enter_button = QPushButton("Enter Process")
 
         self.status_box = QTextEdit()
@@ -124,6 +133,8 @@ class InputWindow(QWidget):
         proc_row.addWidget(self.start_spin)
         proc_row.addWidget(QLabel("Service Time:"))
         proc_row.addWidget(self.duration_spin)
+        proc_row.addWidget(QLabel("Priority:"))
+        proc_row.addWidget(self.priority_spin)
         proc_row.setSpacing(200)
 
         form_layout.addLayout(proc_row)
@@ -146,17 +157,19 @@ class InputWindow(QWidget):
         name = self.name_input.text().strip()
         start = self.start_spin.value()
         duration = self.duration_spin.value()
+        priority = self.priority_spin.value()
 
         if not name:
             self.status_box.append("⚠️ Process name is required.")
             return
 
-        self.entered_processes.append(f"{name},{start},{duration}")
-        self.status_box.append(f"{len(self.entered_processes)}. Process: {name} , Start Time: {start}, Service Time: {duration}")
+        self.entered_processes.append(f"{name},{start},{duration},{priority}")
+        self.status_box.append(f"{len(self.entered_processes)}. Process: {name} , Start Time: {start}, Service Time: {duration}, Priority: {priority}")
 
         self.name_input.clear()
         self.start_spin.setValue(0)
         self.duration_spin.setValue(1)
+        self.priority_spin.setValue(0)
 
         self.total_required = self.num_proc_spin.value()
         if len(self.entered_processes) == self.total_required:
@@ -169,11 +182,19 @@ class InputWindow(QWidget):
         sim_end = self.sim_end_spin.value()
         num_procs = self.num_proc_spin.value()
 
+        if schedsim is not None:
+            try:
+                self.sim_output = self.simulate_in_process(mode, policy, sim_end)
+                self.output_button.setVisible(True)
+            except ValueError as e:
+                self.status_box.append(f"\n❌ Error:\n{e}")
+            return
+
         full_input = f"{mode}\n{policy}\n{sim_end}\n{num_procs}\n" + "\n".join(self.entered_processes) + "\n"
 
         try:
             process = subprocess.Popen(
-                ["./lab6"],
+                ["./lab6", "--format", "json"],
                 stdin=subprocess.PIPE,
                 stdout=subprocess.PIPE,
                 stderr=subprocess.PIPE,
@@ -193,6 +214,91 @@ class InputWindow(QWidget):
         except Exception as e:
             self.status_box.append(f"Exception: {str(e)}")
 
+    @staticmethod
+    def priority_classes(rows):
+        # Per-priority breakdown, highest first, as in the "classes" list of lab6 --format json
+        classes = {}
+        for row in rows:
+            c = classes.setdefault(row["priority"], {"priority": row["priority"], "finished": 0, "unfinished": 0,
+                                                     "meanTurnaround": 0, "maxTurnaround": 0, "maxWait": 0,
+                                                     "meanNormTurn": 0})
+            if row["finish"] is None:
+                c["unfinished"] += 1
+                continue
+            c["finished"] += 1
+            c["meanTurnaround"] += row["turnaround"]
+            c["meanNormTurn"] += row["normTurn"]
+            c["maxTurnaround"] = max(c["maxTurnaround"], row["turnaround"])
+            c["maxWait"] = max(c["maxWait"], row["turnaround"] - row["service"])
+        for c in classes.values():
+            if c["finished"]:
+                c["meanTurnaround"] /= c["finished"]
+                c["meanNormTurn"] /= c["finished"]
+        return [classes[p] for p in sorted(classes, reverse=True)]
+
+    def simulate_in_process(self, mode, policy, sim_end):
+        # Builds the same document as `lab6 --format json` from the schedsim arrays
+        processes = []
+        for entry in self.entered_processes:
+            name, start, duration, priority = entry.rsplit(",", 3)
+            processes.append((name, int(start), int(duration), int(priority)))
+        run = schedsim.simulate(policy, sim_end, processes)
+
+        names = run["names"]
+        arrival = memoryview(run["arrival"]).tolist()
+        finish = memoryview(run["finish"]).tolist()
+        timeline = memoryview(run["timeline"]).tolist()
+        has_stats = "service" in run
+        if mode == "stats" and not has_stats:
+            raise ValueError(f"Unknown mode {mode} for {run['policy']}.")
+        third = memoryview(run["service" if has_stats else "priority"]).tolist()
+        priorities = memoryview(run["priority"]).tolist() if has_stats and "priority" in run else None
+
+        rows = []
+        for i, name in enumerate(names):
+            row = {"name": name, "arrival": arrival[i]}
+            if not has_stats:
+                row["priority"] = third[i]
+            elif finish[i] == 0:
+                row["service"] = third[i]
+                if priorities is not None:
+                    row["priority"] = priorities[i]
+                row["finish"] = None
+            else:
+                turnaround = finish[i] - arrival[i]
+                row["service"] = third[i]
+                if priorities is not None:
+                    row["priority"] = priorities[i]
+                row.update(finish=finish[i], turnaround=turnaround, normTurn=turnaround / third[i])
+            rows.append(row)
+
+        intervals = []
+        for i, cells in enumerate(timeline):
+            t = 0
+            while t < len(cells):
+                if cells[t] == schedsim.IDLE:
+                    t += 1
+                    continue
+                start = t
+                while t < len(cells) and cells[t] == cells[start]:
+                    t += 1
+                state = "running" if cells[start] == schedsim.RUNNING else "ready"
+                intervals.append({"process": names[i], "start": start, "end": t, "state": state})
+
+        result_run = {"policy": run["policy"], "processes": rows}
+        if has_stats and rows:
+            # Means are over the finished processes, as in lab6; None when none finished
+            done = [r for r in rows if r["finish"] is not None]
+            result_run["meanTurnaround"] = sum(r["turnaround"] for r in done) / len(done) if done else None
+            result_run["meanNormTurn"] = sum(r["normTurn"] for r in done) / len(done) if done else None
+        if priorities is not None:
+            result_run["classes"] = self.priority_classes(rows)
+        trajectory = memoryview(run["quantumTrajectory"]).tolist()
+        if trajectory:
+            result_run["quantumTrajectory"] = [{"time": t, "quantum": q} for t, q in trajectory]
+        result_run["intervals"] = intervals
+        return {"mode": mode, "simulationEnd": run["simulationEnd"], "runs": [result_run]}
+
     def show_output_window(self):
         mode = self.mode_box.currentText().lower()
         if mode == "trace":
@@ -1,8 +1,9 @@
+import json
 from PyQt6.QtWidgets import QWidget, QLabel, QVBoxLayout, QTextEdit, QPushButton, QHBoxLayout
 from PyQt6.QtCore import Qt
 
 class StatsWindow(QWidget):
-    def __init__(self, output_text):
+    def __init__(self, output):
         super().__init__()
         self.setWindowTitle("Stats Output")
         self.showFullScreen()
@@ -41,9 +42,8 @@ class StatsWindow(QWidget):
         layout.addWidget(label)
 
         output_box = QTextEdit()
-        output_box.setText(output_text)
         output_box.setReadOnly(True)
-        output_box.setHtml(self.format_output(output_text))
+        output_box.setHtml(self.format_output(output))
         layout.addWidget(output_box)
 
         # Buttons
@@ -60,24 +60,23 @@ class StatsWindow(QWidget):
         layout.addLayout(button_layout)
         self.setLayout(layout)
 
-    def format_output(self, raw_output):
-        lines = [line.strip() for line in raw_output.strip().split('\n') if line.strip()]
-
-        values = []
-        for line in lines:
-            parts = [p.strip() for p in line.split('|') if p.strip()]
-            values.append(parts[1:])
-        
-        processes = values[1]
-        arrival = values[2]
-        service = values[3]
-        finish = values[4]
-        turnaround = values[5]
-        normturn = values[6]
-
-        # Parse mean values
-        mean_turnaround = turnaround[-1]
-        mean_normturn = normturn[-1]
+    def format_output(self, output):
+        # JSON text from lab6, or the same document built in-process from schedsim
+        result = json.loads(output) if isinstance(output, str) else output
+        run = result["runs"][0]
+
+        processes = [p["name"] for p in run["processes"]]
+        arrival = [p["arrival"] for p in run["processes"]]
+        service = [p["service"] for p in run["processes"]]
+        # Unfinished processes have a null finish and no turnaround; they show as "-"
+        finish = ["-" if p["finish"] is None else p["finish"] for p in run["processes"]]
+        turnaround = [p.get("turnaround", "-") for p in run["processes"]]
+        normturn = [f"{p['normTurn']:.2f}" if "normTurn" in p else "-" for p in run["processes"]]
+
+        # Mean values
+        # Means cover the finished processes and are null when none finished
+        mean_turnaround = "-" if run["meanTurnaround"] is None else f"{run['meanTurnaround']:.2f}"
+        mean_normturn = "-" if run["meanNormTurn"] is None else f"{run['meanNormTurn']:.2f}"
 
         # Build HTML table
         html = """
@@ -1,8 +1,9 @@
+import json
 from PyQt6.QtWidgets import QWidget, QLabel, QVBoxLayout, QTextEdit, QPushButton, QHBoxLayout
 from PyQt6.QtCore import Qt
 
 class TraceWindow(QWidget):
-    def __init__(self, output_text):
+    def __init__(self, output):
         super().__init__()
         self.setWindowTitle("Trace Output")
         self.showFullScreen()
@@ -41,9 +42,8 @@ class TraceWindow(QWidget):
         layout.addWidget(label)
 
         output_box = QTextEdit()
-        output_box.setText(output_text)
         output_box.setReadOnly(True)
-        output_box.setHtml(self.format_output(output_text))
+        output_box.setHtml(self.format_output(output))
         layout.addWidget(output_box)
 
         # Buttons
@@ -60,26 +60,24 @@ class TraceWindow(QWidget):
         layout.addLayout(button_layout)
         self.setLayout(layout)
 
-    def format_output(self, raw_output):
-        lines = [line.strip() for line in raw_output.strip().split('\n') if line.strip()]
-
-        # Remove dashed lines
-        lines = [line for line in lines if set(line) != {'-', '|'}]
-
-        # First line: headers (mode + time units)
-        headers = lines[0].split()
-        mode = headers[0]
-        time_headers = headers[1:]
-
-        # Rest: process rows
-        process_rows = []
-        for line in lines[1:]:
-            parts = line.replace('|', ' ').replace('.', '.').split()
-            if not parts: continue
-            label = parts[0]
-            timeline = parts[1:]
-            if label.isalpha():
-                process_rows.append((label, timeline))
+    def format_output(self, output):
+        # JSON text from lab6, or the same document built in-process from schedsim
+        result = json.loads(output) if isinstance(output, str) else output
+        sim_end = result["simulationEnd"]
+        run = result["runs"][0]
+
+        # Header: policy + time units
+        mode = run["policy"]
+        time_headers = [str(t % 10) for t in range(sim_end)]
+
+        # Rebuild one row of cells per process from the schedule intervals
+        cells = {p["name"]: [""] * sim_end for p in run["processes"]}
+        for interval in run["intervals"]:
+            mark = "*" if interval["state"] == "running" else "."
+            row = cells[interval["process"]]
+            for t in range(interval["start"], interval["end"]):
+                row[t] = mark
+        process_rows = [(p["name"], cells[p["name"]]) for p in run["processes"]]
 
         # Create HTML table
         html = f"""
@@ -6,921 +6,1385 @@
 #include <sstream>
 #include <algorithm>
 #include <iomanip>
+#include <charconv>
+#include <cstdio>
+#include <memory>
+#include <functional>
+#include <random>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string_view>
+#include <unordered_map>
+#include <optional>
+
+#include "scheduler.h"
 
-struct Process {
+// ----------------------------------------
+// Indexed trace files: the state-change intervals of one or more runs, laid out so the file can
+// be memory-mapped and queried in place.
+//
+//   TraceFileHeader
+//   per run: TraceInterval arrays of each process, then its TraceProcessEntry table
+//   TraceRunEntry table (at header.runTableOffset)
+//
+// A process's intervals never overlap and are sorted by start, so their ends are sorted too and
+// the first interval of a window [t0, t1) is found by binary search on the end time.
+struct TraceFileHeader {
+    char magic[8];
+    uint32_t byteOrder;
+    uint32_t runCount;
+    uint64_t runTableOffset;
+};
+
+struct TraceRunEntry {
+    char policy[24];
+    int32_t simulationEnd;
+    uint32_t processCount;
+    uint64_t processTableOffset;
+};
+
+struct TraceProcessEntry {
     char name;
-    int arrivalTime;
-    int serviceTime;
-    int finishTime;
-    int initialPriority;
-    int priority;
+    char padding[3];
+    int32_t arrivalTime;
+    uint32_t intervalCount;
+    uint32_t reserved;
+    uint64_t intervalOffset;
+};
 
-    bool operator==(const Process& other) const 
-    {
-        return name == other.name && arrivalTime == other.arrivalTime && serviceTime == other.serviceTime;
-    }
+struct TraceInterval {
+    int32_t start;
+    int32_t end;
+    char state;
+    char padding[3];
 };
 
-class Policy {
-protected:
-    std::vector<Process> processes;
+static const char traceFileMagic[8] = {'S', 'C', 'H', 'E', 'D', 'T', 'R', '1'};
+static const uint32_t traceFileByteOrder = 0x01020304;
 
-public:
-    virtual void executeTrace(int simulationEnd,bool trace) = 0;
-    virtual ~Policy() = default;
+class TraceFileWriter {
+private:
+    std::ofstream file;
+    std::vector<TraceRunEntry> runs;
 
-    void addProcess(const Process& process) {
-        processes.push_back(process);
-    };
+    uint64_t position() {
+        return static_cast<uint64_t>(file.tellp());
+    }
 
-    void executeStats(std::string policy) {
-        std::cout << policy << "\n"; 
+    template <typename T>
+    void writeRecords(const T* records, size_t count) {
+        file.write(reinterpret_cast<const char*>(records), sizeof(T) * count);
+    }
 
-        std::cout << "Process    |";
-        for (const auto& process : processes) {
-            std::cout << "  " << process.name << "  |";
-        }
-        std::cout << "\n";
+public:
+    bool open(const std::string& path) {
+        file.open(path, std::ios::binary | std::ios::trunc);
+        TraceFileHeader header = {};
+        writeRecords(&header, 1);
+        return static_cast<bool>(file);
+    }
 
-        std::cout << "Arrival    |";
-        for (const auto& process : processes) {
-            std::cout << "  " << process.arrivalTime << "  |";
-        }
-        std::cout << "\n";
+    ~TraceFileWriter() {
+        close();
+    }
 
-        std::cout << "Service    |";
-        for (const auto& process : processes) {
-            std::cout << "  " << process.serviceTime << "  |";
+    void addRun(const std::string& policy, const std::vector<Process>& processes, const std::vector<std::vector<char>>& timeline, int simulationEnd) {
+        std::vector<TraceProcessEntry> entries(processes.size());
+        std::vector<TraceInterval> intervals;
+        for (size_t i = 0; i < processes.size(); ++i) {
+            intervals.clear();
+            forEachInterval(timeline[i], [&](int start, int end, char cell) {
+                intervals.push_back(TraceInterval{start, end, cell, {}});
+            });
+            entries[i] = TraceProcessEntry{processes[i].name, {}, processes[i].arrivalTime,
+                                           static_cast<uint32_t>(intervals.size()), 0, position()};
+            writeRecords(intervals.data(), intervals.size());
         }
-        std::cout << " Mean|";
-        std::cout << "\n";
 
-        std::cout << "Finish     |";
-        for (const auto& process : processes) {
-            std::cout << std::setw(3) << std::setfill(' ') << process.finishTime;
-            std::cout << std::setw(3) << std::setfill(' ') << "|";        
+        TraceRunEntry run = {};
+        policy.copy(run.policy, sizeof(run.policy) - 1);
+        run.simulationEnd = simulationEnd;
+        run.processCount = static_cast<uint32_t>(entries.size());
+        run.processTableOffset = position();
+        writeRecords(entries.data(), entries.size());
+        runs.push_back(run);
+    }
+
+    void close() {
+        if (!file.is_open()) {
+            return;
         }
-        std::cout << "-----|";
-        std::cout << "\n";
+        TraceFileHeader header = {};
+        std::memcpy(header.magic, traceFileMagic, sizeof(header.magic));
+        header.byteOrder = traceFileByteOrder;
+        header.runCount = static_cast<uint32_t>(runs.size());
+        header.runTableOffset = position();
+        writeRecords(runs.data(), runs.size());
+        file.seekp(0);
+        writeRecords(&header, 1);
+        file.close();
+    }
+};
 
-        float mean = 0;
-        std::vector<float> turnarounds;
+// Read-only view of a memory-mapped trace file.
+class TraceFile {
+private:
+    const char* data = nullptr;
+    size_t size = 0;
 
-        std::cout << "Turnaround |";
-        for (const auto& process : processes) {
-            int turnaround = process.finishTime - process.arrivalTime;
-            mean += turnaround;
-            turnarounds.push_back(turnaround);
-            std::cout << std::setw(3) << std::setfill(' ') <<  turnaround;
-            std::cout << std::setw(3) << std::setfill(' ') << "|";           
+    template <typename T>
+    const T* records(uint64_t offset, size_t count) const {
+        if (offset > size || count > (size - offset) / sizeof(T)) {
+            return nullptr;
         }
-        std::cout << std::setw(5) << std::setfill(' ') << std::fixed << std::setprecision(2) << mean / processes.size() << "|";      
-        std::cout << "\n";
+        return reinterpret_cast<const T*>(data + offset);
+    }
 
-        int i = 0;
-        mean = 0;
+public:
+    TraceFile() = default;
+    TraceFile(const TraceFile&) = delete;
+    TraceFile& operator=(const TraceFile&) = delete;
 
-        std::cout << "NormTurn   |";
-        for (const auto& process : processes) {
-            float normTurn = turnarounds[i] / process.serviceTime;
-            mean += normTurn;
-            std::cout << std::setw(5) << std::setfill(' ') << std::fixed << std::setprecision(2) << normTurn << "|";
-            i++;    
+    ~TraceFile() {
+        if (data) {
+            munmap(const_cast<char*>(data), size);
         }
-        std::cout << std::setw(5) << std::setfill(' ') << std::fixed << std::setprecision(2) << mean / processes.size() << "|";      
-        std::cout << "\n\n";
     }
 
+    bool open(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(TraceFileHeader)) {
+            size = info.st_size;
+            void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            data = mapped == MAP_FAILED ? nullptr : static_cast<const char*>(mapped);
+        }
+        ::close(fd);
 
-    void displayTraceTimeline(std::string policy, const std::vector<Process>& processes, const std::vector<std::vector<char>>& timeline, int simulationEnd) {
-    std::cout << policy;
-    for (int t = 0; t < simulationEnd+1; ++t) {
-        std::cout << t % 10 << " ";
+        const TraceFileHeader* header = data ? records<TraceFileHeader>(0, 1) : nullptr;
+        return header && std::memcmp(header->magic, traceFileMagic, sizeof(header->magic)) == 0 &&
+               header->byteOrder == traceFileByteOrder && runs() != nullptr;
     }
-    std::cout << "\n" << std::string(simulationEnd * 2 + 8, '-') << "\n";
 
-    for (size_t i = 0; i < processes.size(); ++i) {
-        std::cout << processes[i].name << "     ";
-        for (int t = 0; t < simulationEnd; ++t) {
-            if (timeline[i][t] == '*' || timeline[i][t] == '.') {
-                std::cout << "|" << timeline[i][t];
-            } else {
-                std::cout << "| ";
-            }
+    uint32_t runCount() const {
+        return records<TraceFileHeader>(0, 1)->runCount;
+    }
 
-            if(t == simulationEnd - 1) {
-                std::cout << "| ";
-            }
-        }
-        std::cout << "\n";
+    const TraceRunEntry* runs() const {
+        const TraceFileHeader* header = records<TraceFileHeader>(0, 1);
+        return records<TraceRunEntry>(header->runTableOffset, header->runCount);
     }
 
-    std::cout << std::string(simulationEnd * 2 + 8, '-') << "\n";
-    std::cout << "\n";
-}
+    const TraceProcessEntry* processes(const TraceRunEntry& run) const {
+        return records<TraceProcessEntry>(run.processTableOffset, run.processCount);
+    }
 
+    // Intervals of one process that overlap [t0, t1), as a pointer range into the mapping.
+    std::pair<const TraceInterval*, const TraceInterval*> window(const TraceProcessEntry& process, int t0, int t1) const {
+        const TraceInterval* begin = records<TraceInterval>(process.intervalOffset, process.intervalCount);
+        if (!begin) {
+            return {nullptr, nullptr};
+        }
+        const TraceInterval* end = begin + process.intervalCount;
+        const TraceInterval* first = std::partition_point(begin, end, [&](const TraceInterval& i) { return i.end <= t0; });
+        const TraceInterval* last = std::partition_point(first, end, [&](const TraceInterval& i) { return i.start < t1; });
+        return {first, last};
+    }
 };
 
-// ----------------------------------------
-class FCFS : public Policy {
-public:
-    void executeTrace(int simulationEnd, bool trace) {
-        std::vector<Process> readyQueue;
-        Process currentProcess;
-        bool isExecuting = false;
-        int currentTime = 0;
-
-        std::vector<std::vector<char>> timeline(processes.size(), std::vector<char>(simulationEnd, ' '));
-
-        while (currentTime < simulationEnd) {
-            for (size_t i = 0; i < processes.size(); ++i) {
-                if (processes[i].arrivalTime == currentTime) {
-                    readyQueue.push_back(processes[i]);
-                }
-            }
-
-            for (size_t i = 0; i < processes.size(); ++i) {
-                if (std::find_if(readyQueue.begin(), readyQueue.end(), [&](const Process& p) { return p.name == processes[i].name; }) != readyQueue.end()) {
-                    timeline[i][currentTime] = '.';
-                }
-            }
+// Prints the schedule of [t0, t1) from a trace file, optionally limited to one policy and to the
+// processes named in processFilter. Intervals are clipped to the window.
+int queryTraceFile(const std::string& path, int t0, int t1, const std::string& policyFilter, const std::string& processFilter) {
+    TraceFile trace;
+    if (!trace.open(path)) {
+        std::cerr << "Error: Cannot read trace file " << path << ".\n";
+        return 1;
+    }
 
-            if (!isExecuting && !readyQueue.empty()) {
-                currentProcess = readyQueue.front();
-                isExecuting = true;
+    std::string out;
+    char digits[16];
+    for (uint32_t r = 0; r < trace.runCount(); ++r) {
+        const TraceRunEntry& run = trace.runs()[r];
+        std::string policy(run.policy, strnlen(run.policy, sizeof(run.policy)));
+        if (!policyFilter.empty() && policy != policyFilter) {
+            continue;
+        }
+        const TraceProcessEntry* processes = trace.processes(run);
+        for (uint32_t p = 0; processes && p < run.processCount; ++p) {
+            if (!processFilter.empty() && processFilter.find(processes[p].name) == std::string::npos) {
+                continue;
             }
-
-            if (isExecuting) {
-                auto it = std::find_if(processes.begin(), processes.end(), [&](const Process& p) { return p.name == currentProcess.name; });
-                size_t index = std::distance(processes.begin(), it);
-                timeline[index][currentTime] = '*';
-                --currentProcess.serviceTime;
-
-                if (currentProcess.serviceTime == 0) {
-                    for(auto& process : processes) {
-                        if(process.name == currentProcess.name)
-                            process.finishTime = currentTime + 1;
-                    }
-                    currentProcess.finishTime = currentTime + 1;
-                    readyQueue.erase(readyQueue.begin());
-                    isExecuting = false;
-                }
+            auto range = trace.window(processes[p], t0, t1);
+            for (const TraceInterval* i = range.first; i != range.second; ++i) {
+                out += policy;
+                out += ' ';
+                out += processes[p].name;
+                out += ' ';
+                out.append(digits, std::to_chars(digits, digits + sizeof(digits), std::max(i->start, t0)).ptr);
+                out += ' ';
+                out.append(digits, std::to_chars(digits, digits + sizeof(digits), std::min(i->end, t1)).ptr);
+                out += ' ';
+                out += stateName(i->state);
+                out += '\n';
             }
-            ++currentTime;
         }
-
-        if(trace)
-            displayTraceTimeline("FCFS  ", processes, timeline, simulationEnd);
     }
-};
+    std::cout << out;
+    return 0;
+}
 
 // ----------------------------------------
-class RoundRobin : public Policy{
+// Chrome trace-event export (JSON array format, readable by chrome://tracing and the Perfetto
+// UI). Events are written as the run produces them, and a file cut off mid-run still loads,
+// because viewers accept an array without its closing bracket. Each run is a process, each job
+// a thread with "running" and "ready" slices, the ready queue a counter track and preemptions
+// instant events. One tick is tickUs microseconds.
+class ChromeTraceWriter {
 private:
-    int quantum;
+    static const size_t flushThreshold = 1 << 16;
 
-public:
-    void setQuantum(int q) {
-        quantum = q;    
-    }
+    std::ofstream file;
+    std::string buffer;
+    double tickUs = 1000;
+    bool firstEvent = true;
+    int runCount = 0;
 
-void executeTrace(int simulationEnd, bool trace) {
-    std::queue<Process> readyQueue;
-    int currentTime = 0;
-    
-    Process temp;
-    int pushTime = -1;
+    void appendInt(long long value) {
+        char digits[24];
+        buffer.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr);
+    }
 
-    std::vector<std::vector<char>> timeline(processes.size(), std::vector<char>(simulationEnd, ' '));
-    std::vector<bool> isInQueue(processes.size(), false);
+    void appendTime(int64_t tick) {
+        char digits[32];
+        buffer.append(digits, std::to_chars(digits, digits + sizeof(digits), tick * tickUs).ptr);
+    }
 
-    while (currentTime < simulationEnd) {
-        for (size_t i = 0; i < processes.size(); ++i) {
-            if (processes[i].arrivalTime <= currentTime && !isInQueue[i]) {
-                readyQueue.push(processes[i]);
-                isInQueue[i] = true;
+    void appendString(const std::string& text) {
+        buffer += '"';
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                buffer += '\\';
+                buffer += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                buffer += escaped;
+            } else {
+                buffer += c;
             }
         }
+        buffer += '"';
+    }
+
+    // Starts an event object: {"ph":..,"pid":..,"tid":..
+    void beginEvent(char phase, int pid, uint64_t tid) {
+        buffer += firstEvent ? "\n{\"ph\":\"" : ",\n{\"ph\":\"";
+        firstEvent = false;
+        buffer += phase;
+        buffer += "\",\"pid\":";
+        appendInt(pid);
+        buffer += ",\"tid\":";
+        appendInt(static_cast<long long>(tid));
+    }
 
-        if(pushTime == currentTime) {
-            readyQueue.push(temp);
+    void endEvent() {
+        buffer += '}';
+        if (buffer.size() >= flushThreshold) {
+            flush();
         }
+    }
 
-        if (!readyQueue.empty()) {
-            Process currentProcess = readyQueue.front();
-            readyQueue.pop();
+public:
+    bool open(const std::string& path, double microsecondsPerTick) {
+        file.open(path, std::ios::trunc);
+        tickUs = microsecondsPerTick;
+        buffer = "[";
+        return static_cast<bool>(file);
+    }
 
-            int executionTime = std::min(quantum, currentProcess.serviceTime);
-            currentProcess.serviceTime -= executionTime;
+    ~ChromeTraceWriter() {
+        close();
+    }
 
-            for (size_t i = 0; i < processes.size(); ++i) {
-            if (processes[i].arrivalTime <= currentTime+executionTime && !isInQueue[i]) {
-                readyQueue.push(processes[i]);
-                isInQueue[i] = true;
-            }
-        }
+    bool isOpen() const {
+        return file.is_open();
+    }
 
-            for (int t = 0; t < executionTime; ++t) {
-                auto it = std::find_if(processes.begin(), processes.end(), [&](const Process& p) {
-                    return p.name == currentProcess.name;
-                });
-                size_t index = std::distance(processes.begin(), it);
-                if (currentTime + t < simulationEnd) {
-                    timeline[index][currentTime + t] = '*';
-                }
+    // A new process track for the next run; returns its pid.
+    int beginRun(const std::string& name) {
+        int pid = ++runCount;
+        beginEvent('M', pid, 0);
+        buffer += ",\"name\":\"process_name\",\"args\":{\"name\":";
+        appendString(name);
+        buffer += '}';
+        endEvent();
+        return pid;
+    }
 
-                std::queue<Process> tempQueue = readyQueue; 
-                while (!tempQueue.empty()) {
-                    Process queuedProcess = tempQueue.front();
-                    tempQueue.pop();
+    void thread(int pid, uint64_t tid, const std::string& name) {
+        beginEvent('M', pid, tid);
+        buffer += ",\"name\":\"thread_name\",\"args\":{\"name\":";
+        appendString(name);
+        buffer += '}';
+        endEvent();
+    }
 
-                    auto queuedIt = std::find_if(processes.begin(), processes.end(), [&](const Process& p) {
-                        return p.name == queuedProcess.name;
-                    });
-                    size_t queuedIndex = std::distance(processes.begin(), queuedIt);
+    void slice(int pid, uint64_t tid, const char* name, int64_t start, int64_t end) {
+        beginEvent('X', pid, tid);
+        buffer += ",\"name\":\"";
+        buffer += name;
+        buffer += "\",\"ts\":";
+        appendTime(start);
+        buffer += ",\"dur\":";
+        appendTime(end - start);
+        endEvent();
+    }
 
-                    if (currentTime + t >= processes[queuedIndex].arrivalTime && currentTime + t < simulationEnd) {   
-                        timeline[queuedIndex][currentTime + t] = '.';
-                    }
-                }
-            }
+    void counter(int pid, const char* name, int64_t time, long long value) {
+        beginEvent('C', pid, 0);
+        buffer += ",\"name\":\"";
+        buffer += name;
+        buffer += "\",\"ts\":";
+        appendTime(time);
+        buffer += ",\"args\":{\"jobs\":";
+        appendInt(value);
+        buffer += '}';
+        endEvent();
+    }
 
-            currentTime += executionTime;
+    void instant(int pid, uint64_t tid, const char* name, int64_t time) {
+        beginEvent('i', pid, tid);
+        buffer += ",\"s\":\"t\",\"name\":\"";
+        buffer += name;
+        buffer += "\",\"ts\":";
+        appendTime(time);
+        endEvent();
+    }
 
-            if (currentProcess.serviceTime > 0) {
-                temp = currentProcess;
-                pushTime = currentTime;
-            } else {
-                auto it = std::find_if(processes.begin(), processes.end(), [&](const Process& p) {
-                    return p.name == currentProcess.name;
-                });
-                if (it != processes.end()) {
-                    it->finishTime = currentTime;
+    // A finished run of a reference policy, from its timeline: a running interval that ends
+    // before the process finishes is a preemption.
+    void addRun(const std::string& policy, const std::vector<Process>& processes, const std::vector<std::vector<char>>& timeline, int simulationEnd) {
+        int pid = beginRun(policy);
+        for (size_t i = 0; i < processes.size(); ++i) {
+            thread(pid, i + 1, std::string(1, processes[i].name));
+            int finish = processes[i].finishTime;
+            forEachInterval(timeline[i], [&](int start, int end, char cell) {
+                slice(pid, i + 1, stateName(cell), start, end);
+                if (cell == '*' && end < simulationEnd && end != finish) {
+                    instant(pid, i + 1, "preempted", end);
                 }
+            });
+        }
+        long long previous = -1;
+        for (int t = 0; t < simulationEnd; ++t) {
+            long long waiting = 0;
+            for (const auto& row : timeline) {
+                waiting += row[t] == '.';
+            }
+            if (waiting != previous) {
+                counter(pid, "ready queue", t, waiting);
+                previous = waiting;
             }
-        } else {
-            ++currentTime;
         }
+        flush();
     }
 
-    if (trace) {
-        displayTraceTimeline("RR-" + std::to_string(quantum) + "  ", processes, timeline, simulationEnd);
+    void flush() {
+        if (file.is_open() && !buffer.empty()) {
+            file.write(buffer.data(), buffer.size());
+            file.flush();
+            buffer.clear();
+        }
     }
-}
 
+    void close() {
+        if (file.is_open()) {
+            buffer += "\n]\n";
+            flush();
+            file.close();
+        }
+    }
 };
 
-// ----------------------------------------
-class SPN : public Policy {
+// Streams an online-engine run into a ChromeTraceWriter as it is simulated. A job's ready slice
+// runs from its arrival or last slice to its next slice or finish. A slice that is not
+// immediately followed by its job's finish was a preemption; one still open when the run ends is
+// marked "end" instead, since the run cut it off.
+class ChromeTraceObserver : public OnlineObserver {
+private:
+    ChromeTraceWriter& writer;
+    int pid;
+    std::unordered_map<uint64_t, int64_t> readySince;
+    long long queueLength = -1;
+    uint64_t pendingSeq = 0;  // job whose slice just ended, if it may have been preempted
+    int64_t pendingTime = 0;
+
+    void resolvePending() {
+        if (pendingSeq) {
+            writer.instant(pid, pendingSeq, "preempted", pendingTime);
+            pendingSeq = 0;
+        }
+    }
+
 public:
-    void executeTrace(int simulationEnd, bool trace) override {
-        std::vector<Process> readyQueue;
-        Process currentProcess;
-        bool isExecuting = false;
-        int currentTime = 0;
-
-        std::vector<std::vector<char>> timeline(processes.size(), std::vector<char>(simulationEnd, ' '));
-
-        while (currentTime < simulationEnd) {
-            for (size_t i = 0; i < processes.size(); ++i) {
-                if (processes[i].arrivalTime == currentTime) {
-                    readyQueue.push_back(processes[i]);
-                }
-            }
+    ChromeTraceObserver(ChromeTraceWriter& writer, const std::string& policy) : writer(writer), pid(writer.beginRun(policy)) {}
 
-            for (size_t i = 0; i < processes.size(); ++i) {
-                if (std::find_if(readyQueue.begin(), readyQueue.end(), [&](const Process& p) { return p.name == processes[i].name; }) != readyQueue.end()) {
-                    timeline[i][currentTime] = '.';
-                }
-            }
+    void onArrival(const OnlineJob& job) override {
+        resolvePending();
+        writer.thread(pid, job.seq, job.name);
+        readySince[job.seq] = job.arrival;
+    }
 
-            if (!isExecuting && !readyQueue.empty()) {
-                std::sort(readyQueue.begin(), readyQueue.end(), [](const Process& a, const Process& b) {
-                    return a.serviceTime < b.serviceTime;
-                });
-                currentProcess = readyQueue.front();
-                isExecuting = true;
-            }
-
-            if (isExecuting) {
-                auto it = std::find_if(processes.begin(), processes.end(), [&](const Process& p) { return p.name == currentProcess.name; });
-                size_t index = std::distance(processes.begin(), it);
-                timeline[index][currentTime] = '*';
-                --currentProcess.serviceTime;
-
-                if (currentProcess.serviceTime == 0) {
-                    for(auto& process : processes) {
-                        if(process.name == currentProcess.name)
-                            process.finishTime = currentTime + 1;
-                    }
-                    currentProcess.finishTime = currentTime + 1;
-                    readyQueue.erase(readyQueue.begin());
-                    isExecuting = false;
-                }
-            }
-            ++currentTime;
+    void onSlice(const OnlineJob& job, int64_t start, int64_t end) override {
+        resolvePending();
+        int64_t& since = readySince[job.seq];
+        if (start > since) {
+            writer.slice(pid, job.seq, "ready", since, start);
         }
-
-        if(trace)
-            displayTraceTimeline("SPN   ", processes, timeline, simulationEnd);
+        writer.slice(pid, job.seq, "running", start, end);
+        since = end;
+        pendingSeq = job.seq;
+        pendingTime = end;
     }
 
-};
-
-// ----------------------------------------
-class SRT : public Policy {
-public: 
-    void executeTrace(int simulationEnd, bool trace) {
-        std::vector<Process> readyQueue;
-        Process currentProcess;
-        bool isExecuting = false;
-        int currentTime = 0;
-
-        std::vector<std::vector<char>> timeline(processes.size(), std::vector<char>(simulationEnd, ' '));
-
-        while (currentTime < simulationEnd) {
-            for (size_t i = 0; i < processes.size(); ++i) {
-                if (processes[i].arrivalTime == currentTime) {
-                    readyQueue.push_back(processes[i]);
-                }
-            }
-
-            for (size_t i = 0; i < processes.size(); ++i) {
-                if (std::find_if(readyQueue.begin(), readyQueue.end(), [&](const Process& p) { return p.name == processes[i].name; }) != readyQueue.end()) {
-                    timeline[i][currentTime] = '.';
-                }
-            }
+    void onFinish(const OnlineJob& job, int64_t time) override {
+        if (pendingSeq == job.seq && pendingTime == time) {
+            pendingSeq = 0;
+        }
+        resolvePending();
+        readySince.erase(job.seq);
+    }
 
-            if (!isExecuting && !readyQueue.empty()) {
-                std::sort(readyQueue.begin(), readyQueue.end(), [](const Process& a, const Process& b) {
-                    return a.serviceTime < b.serviceTime;
-                });
-                currentProcess = readyQueue.front();
-                isExecuting = true;
-            }
-
-            if (isExecuting) {
-                auto it = std::find_if(processes.begin(), processes.end(), [&](const Process& p) { return p.name == currentProcess.name; });
-                size_t index = std::distance(processes.begin(), it);
-                timeline[index][currentTime] = '*';
-                --currentProcess.serviceTime;
-                readyQueue.front().serviceTime = currentProcess.serviceTime;
-
-                if (currentProcess.serviceTime == 0) {
-                    for(auto& process : processes) {
-                        if(process.name == currentProcess.name)
-                            process.finishTime = currentTime + 1;
-                    }
-                    currentProcess.finishTime = currentTime + 1;
-                    readyQueue.erase(readyQueue.begin());
-                }
-                isExecuting = false;
-            }
-            ++currentTime;
+    void onInterval(int64_t from, int64_t, size_t waiting, bool) override {
+        if (static_cast<long long>(waiting) != queueLength) {
+            queueLength = static_cast<long long>(waiting);
+            writer.counter(pid, "ready queue", from, queueLength);
         }
+    }
 
-        if(trace)
-            displayTraceTimeline("SRT   ", processes, timeline, simulationEnd);
+    void close() {
+        if (pendingSeq) {
+            writer.instant(pid, pendingSeq, "end", pendingTime);
+            pendingSeq = 0;
+        }
+        writer.flush();
     }
 };
 
 // ----------------------------------------
-class HRRN : public Policy {
-public:
-    void executeTrace(int simulationEnd, bool trace) override {
-    std::vector<Process> readyQueue;
-    Process currentProcess;
-    bool isExecuting = false;
-    int currentTime = 0;
+enum class OutputFormat { Text, Json, Csv };
 
-    std::vector<std::vector<char>> timeline(processes.size(), std::vector<char>(simulationEnd, ' '));
+// Serializes runs as JSON or CSV into one growing buffer that is flushed to the output stream in
+// large blocks, so results for big workloads never go through iostream formatting. Text output
+// and errors of a scenario go to the same pair of streams.
+class ResultWriter {
+private:
+    static const size_t flushThreshold = 1 << 16;
+
+    OutputFormat format;
+    std::ostream& out;
+    std::ostream& err;
+    std::string buffer;
+    std::string scenarioId;
+    TraceFileWriter* traceFile = nullptr;
+    ResultCache* cache = nullptr;
+    ChromeTraceWriter* chromeTrace = nullptr;
+    const SpeedModel* speedModel = nullptr;
+    bool begun = false;
+    bool firstRun = true;
+
+    void append(const char* text) {
+        buffer.append(text);
+    }
 
-    while (currentTime < simulationEnd) {
-        for (size_t i = 0; i < processes.size(); ++i) {
-            if (processes[i].arrivalTime == currentTime) {
-                readyQueue.push_back(processes[i]);
-            }
-        }
+    void append(const std::string& text) {
+        buffer.append(text);
+    }
 
-        for (size_t i = 0; i < processes.size(); ++i) {
-            if (std::find_if(readyQueue.begin(), readyQueue.end(), [&](const Process& p) { return p.name == processes[i].name; }) != readyQueue.end()) {
-                timeline[i][currentTime] = '.';
-            }
-        }
+    void append(char c) {
+        buffer.push_back(c);
+    }
 
-        if (!isExecuting && !readyQueue.empty()) {
-            float maxRR = -1.0; 
-            size_t selectedIndex = 0;
+    void appendInt(long long value) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        buffer.append(digits, result.ptr);
+    }
 
-            for (size_t i = 0; i < readyQueue.size(); ++i) {
-                int waitingTime = currentTime - readyQueue[i].arrivalTime;
-                float responseRatio = (waitingTime + readyQueue[i].serviceTime) / float(readyQueue[i].serviceTime);
+    void appendDouble(double value) {
+        char digits[32];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        buffer.append(digits, result.ptr);
+    }
 
-                if (responseRatio > maxRR) {
-                    maxRR = responseRatio;
-                    selectedIndex = i;
-                }
+    void appendJsonString(const std::string& text) {
+        append('"');
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                append('\\');
+                append(c);
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                append(escaped);
+            } else {
+                append(c);
             }
-
-            currentProcess = readyQueue[selectedIndex];
-            readyQueue.erase(readyQueue.begin() + selectedIndex);
-            isExecuting = true;
         }
+        append('"');
+    }
 
-        if (isExecuting) {
-            auto it = std::find_if(processes.begin(), processes.end(), [&](const Process& p) { return p.name == currentProcess.name; });
-            size_t index = std::distance(processes.begin(), it);
-            timeline[index][currentTime] = '*';
-            --currentProcess.serviceTime;
+    void appendCsvField(const std::string& text) {
+        if (text.find_first_of(",\"\n") == std::string::npos) {
+            append(text);
+            return;
+        }
+        append('"');
+        for (char c : text) {
+            if (c == '"') append('"');
+            append(c);
+        }
+        append('"');
+    }
 
-            if (currentProcess.serviceTime == 0) {
-                for (auto& process : processes) {
-                    if (process.name == currentProcess.name)
-                        process.finishTime = currentTime + 1;
-                }
-                isExecuting = false;
-            }
+    void beginCsvRow(const char* record) {
+        if (!scenarioId.empty()) {
+            appendCsvField(scenarioId);
+            append(',');
         }
-        ++currentTime;
+        append(record);
     }
 
-    if (trace) {
-        displayTraceTimeline("HRRN  ", processes, timeline, simulationEnd);
+    void flushIfFull() {
+        if (buffer.size() >= flushThreshold) {
+            flush();
+        }
     }
-}
-};
 
-// ----------------------------------------
-class Feedback1 : public Policy {
-public:
-    void executeTrace(int simulationEnd, bool trace) {
-        std::vector<std::queue<Process>> readyQueues;
-        int currentTime = 0;
-        int processNum = 0;
-
-        std::vector<std::vector<char>> timeline(processes.size(), std::vector<char>(simulationEnd, ' '));
-
-        std::vector<bool> isInQueue(processes.size(), false);
-
-        Process currentProcess;
-        int remainingQuantum = 0;
-        bool isExecuting = false;
-
-        while (currentTime < simulationEnd) {
-            for (size_t i = 0; i < processes.size(); ++i) {
-                if (processes[i].arrivalTime == currentTime && !isInQueue[i]) {
-                    if (readyQueues.empty()) {
-                        readyQueues.emplace_back(); 
-                    }
-                    readyQueues[0].push(processes[i]);
-                    isInQueue[i] = true;
-                    processNum++;
-                }
+    void writeJsonRun(const std::string& policy, const std::vector<Process>& processes,
+                      const std::vector<std::vector<char>>& timeline, const std::vector<QuantumChange>& quantumTrajectory,
+                      const EnergyReport& energy, bool hasStats, bool prioritized) {
+        append(firstRun ? "\n" : ",\n");
+        append("{\"policy\":");
+        appendJsonString(policy);
+
+        double turnaroundSum = 0, normTurnSum = 0;
+        size_t finished = 0;
+        append(",\"processes\":[");
+        for (size_t i = 0; i < processes.size(); ++i) {
+            const Process& process = processes[i];
+            append(i == 0 ? "\n" : ",\n");
+            append("{\"name\":");
+            appendJsonString(std::string(1, process.name));
+            append(",\"arrival\":");
+            appendInt(process.arrivalTime);
+            if (!hasStats) {
+                append(",\"priority\":");
+                appendInt(process.initialPriority);
+                append('}');
+                continue;
+            }
+            append(",\"service\":");
+            appendInt(process.serviceTime);
+            if (prioritized) {
+                append(",\"priority\":");
+                appendInt(process.initialPriority);
+            }
+            append(",\"finish\":");
+            if (process.finishTime == 0) {
+                append("null}");
+                continue;
             }
+            int turnaround = process.finishTime - process.arrivalTime;
+            double normTurn = double(turnaround) / process.serviceTime;
+            turnaroundSum += turnaround;
+            normTurnSum += normTurn;
+            ++finished;
+            appendInt(process.finishTime);
+            append(",\"turnaround\":");
+            appendInt(turnaround);
+            append(",\"normTurn\":");
+            appendDouble(normTurn);
+            if (!energy.perProcess.empty()) {
+                append(",\"energy\":");
+                appendDouble(energy.perProcess[i]);
+            }
+            append('}');
+            flushIfFull();
+        }
+        append("]");
 
-            for (size_t i = 0; i < processes.size(); ++i) {
-                bool inQueue = false;
-                for (const auto& queue : readyQueues) {
-                    std::queue<Process> tempQueue = queue;
-                    while (!tempQueue.empty()) {
-                        if (tempQueue.front().name == processes[i].name) {
-                            inQueue = true;
-                            break;
-                        }
-                        tempQueue.pop();
-                    }
-                    if (inQueue) break;
-                }
-                if (inQueue && !(isExecuting && currentProcess.name == processes[i].name)) {
-                    timeline[i][currentTime] = '.';
-                }
+        // Means are over the finished processes; null when none finished.
+        if (hasStats && !processes.empty()) {
+            append(",\"meanTurnaround\":");
+            if (finished == 0) {
+                append("null,\"meanNormTurn\":null");
+            } else {
+                appendDouble(turnaroundSum / finished);
+                append(",\"meanNormTurn\":");
+                appendDouble(normTurnSum / finished);
             }
+        }
 
-            if (!isExecuting) {
-                for (size_t i = 0; i < readyQueues.size(); ++i) {
-                    if (!readyQueues[i].empty()) {
-                        currentProcess = readyQueues[i].front();
-                        remainingQuantum = 1; 
-                        isExecuting = true;
-                        break;
-                    }
-                    else if(processNum == 1) {
-                        if(i == 0) {
-                            readyQueues[i].push(readyQueues[i+1].front());
-                            readyQueues[i+1].pop();
-                            currentProcess = readyQueues[i].front();
-                            remainingQuantum = 1 << i;
-                            isExecuting = true;
-                            break;
-                        }
-                    }
-                }
+        if (prioritized) {
+            append(",\"classes\":[");
+            bool firstClass = true;
+            for (const auto& c : priorityClassStats(processes)) {
+                append(firstClass ? "{\"priority\":" : ",{\"priority\":");
+                firstClass = false;
+                appendInt(c.priority);
+                append(",\"finished\":");
+                appendInt(c.finished);
+                append(",\"unfinished\":");
+                appendInt(c.unfinished);
+                append(",\"meanTurnaround\":");
+                appendDouble(c.meanTurnaround);
+                append(",\"maxTurnaround\":");
+                appendInt(c.maxTurnaround);
+                append(",\"maxWait\":");
+                appendInt(c.maxWait);
+                append(",\"meanNormTurn\":");
+                appendDouble(c.meanNormTurn);
+                append('}');
             }
+            append(']');
+        }
 
-            if (isExecuting) {
-                auto it = std::find_if(processes.begin(), processes.end(), [&](const Process& p) {
-                    return p.name == currentProcess.name;
-                });
-                size_t index = std::distance(processes.begin(), it);
-                timeline[index][currentTime] = '*';
-
-                --currentProcess.serviceTime;
-                --remainingQuantum;
-                
-                if (currentProcess.serviceTime == 0 || remainingQuantum == 0) {
-                    for (size_t i = 0; i < readyQueues.size(); ++i) {
-                        if (!readyQueues[i].empty() && readyQueues[i].front().name == currentProcess.name) {
-                            readyQueues[i].pop();
-                            if (remainingQuantum == 0 && currentProcess.serviceTime > 0) {
-                                size_t nextQueueIndex = i + 1;
-                                if (nextQueueIndex >= readyQueues.size()) {
-                                    readyQueues.emplace_back(); 
-                                }
-                                readyQueues[nextQueueIndex].push(currentProcess); 
-                            } else if (currentProcess.serviceTime == 0) {
-                                auto it = std::find_if(processes.begin(), processes.end(), [&](const Process& p) {
-                                    return p.name == currentProcess.name;
-                                });
-                                if (it != processes.end()) {
-                                    it->finishTime = currentTime + 1;
-                                }
-                            }
-                            break;
-                        }
-                    }
-                    isExecuting = false;
-                }
+        if (!energy.perProcess.empty()) {
+            append(",\"energy\":{\"total\":");
+            appendDouble(energy.total);
+            append(",\"static\":");
+            appendDouble(energy.staticEnergy);
+            append(",\"meanFrequency\":");
+            appendDouble(energy.meanFrequency);
+            append('}');
+        }
+
+        if (!quantumTrajectory.empty()) {
+            append(",\"quantumTrajectory\":[");
+            for (size_t i = 0; i < quantumTrajectory.size(); ++i) {
+                append(i == 0 ? "{\"time\":" : ",{\"time\":");
+                appendInt(quantumTrajectory[i].time);
+                append(",\"quantum\":");
+                appendInt(quantumTrajectory[i].quantum);
+                append('}');
             }
-            ++currentTime;
+            append(']');
         }
 
-        if (trace) {
-            displayTraceTimeline("FB-1  ", processes, timeline, simulationEnd);
+        append(",\"intervals\":[");
+        bool firstInterval = true;
+        for (size_t i = 0; i < timeline.size(); ++i) {
+            forEachInterval(timeline[i], [&](int start, int end, char cell) {
+                append(firstInterval ? "\n" : ",\n");
+                firstInterval = false;
+                append("{\"process\":");
+                appendJsonString(std::string(1, processes[i].name));
+                append(",\"start\":");
+                appendInt(start);
+                append(",\"end\":");
+                appendInt(end);
+                append(",\"state\":\"");
+                append(stateName(cell));
+                append("\"}");
+                flushIfFull();
+            });
         }
+        append("]}");
     }
-};
 
-// ----------------------------------------
-class Feedback2i : public Policy {
-public:
-    void executeTrace(int simulationEnd, bool trace) override {
-        std::vector<std::queue<Process>> readyQueues;
-        int currentTime = 0;
-        int processNum = 0;
-
-        std::vector<std::vector<char>> timeline(processes.size(), std::vector<char>(simulationEnd, ' '));
-
-        std::vector<bool> isInQueue(processes.size(), false);
-
-        Process currentProcess;
-        int remainingQuantum = 0;
-        bool isExecuting = false;
-
-        while (currentTime < simulationEnd) {
-            for (size_t i = 0; i < processes.size(); ++i) {
-                if (processes[i].arrivalTime == currentTime && !isInQueue[i]) {
-                    if (readyQueues.empty()) {
-                        readyQueues.emplace_back(); 
-                    }
-                    readyQueues[0].push(processes[i]);
-                    isInQueue[i] = true;
-                    processNum++;
-                }
-            }
+    void writeCsvRun(const std::string& policy, const std::vector<Process>& processes,
+                     const std::vector<std::vector<char>>& timeline, const std::vector<QuantumChange>& quantumTrajectory,
+                     const EnergyReport& energy, bool hasStats, bool prioritized) {
+        for (size_t i = 0; i < timeline.size(); ++i) {
+            forEachInterval(timeline[i], [&](int start, int end, char cell) {
+                beginCsvRow("interval,");
+                appendCsvField(policy);
+                append(',');
+                appendCsvField(std::string(1, processes[i].name));
+                append(',');
+                appendInt(start);
+                append(',');
+                appendInt(end);
+                append(',');
+                append(stateName(cell));
+                append(",,,,,\n");
+                flushIfFull();
+            });
+        }
 
-            for (size_t i = 0; i < processes.size(); ++i) {
-                bool inQueue = false;
-                for (const auto& queue : readyQueues) {
-                    std::queue<Process> tempQueue = queue;
-                    while (!tempQueue.empty()) {
-                        if (tempQueue.front().name == processes[i].name) {
-                            inQueue = true;
-                            break;
-                        }
-                        tempQueue.pop();
-                    }
-                    if (inQueue) break;
-                }
-                if (inQueue && !(isExecuting && currentProcess.name == processes[i].name)) {
-                    timeline[i][currentTime] = '.';
-                }
-            }
+        // A quantum row covers [start, end) and carries the quantum in the service column.
+        for (size_t i = 0; i < quantumTrajectory.size(); ++i) {
+            beginCsvRow("quantum,");
+            appendCsvField(policy);
+            append(",,");
+            appendInt(quantumTrajectory[i].time);
+            append(',');
+            if (i + 1 < quantumTrajectory.size()) appendInt(quantumTrajectory[i + 1].time);
+            append(",,,");
+            appendInt(quantumTrajectory[i].quantum);
+            append(",,,\n");
+        }
 
-            if (!isExecuting) {
-                for (size_t i = 0; i < readyQueues.size(); ++i) {
-                    if (!readyQueues[i].empty()) {
-                        currentProcess = readyQueues[i].front();
-                        remainingQuantum = 1 << i; 
-                        isExecuting = true;
-                        break;
-                    }
-                    else if(processNum == 1) {
-                        if(i == 0) {
-                            readyQueues[i].push(readyQueues[i+1].front());
-                            readyQueues[i+1].pop();
-                            currentProcess = readyQueues[i].front();
-                            remainingQuantum = 1 << i;
-                            isExecuting = true;
-                            break;
-                        }
-                    }
-                }
+        if (!hasStats) {
+            return;
+        }
+
+        double turnaroundSum = 0, normTurnSum = 0;
+        size_t finished = 0;
+        for (const auto& process : processes) {
+            beginCsvRow("process,");
+            appendCsvField(policy);
+            append(',');
+            appendCsvField(std::string(1, process.name));
+            append(",,,,");
+            appendInt(process.arrivalTime);
+            append(',');
+            appendInt(process.serviceTime);
+            append(',');
+            if (process.finishTime != 0) {
+                int turnaround = process.finishTime - process.arrivalTime;
+                double normTurn = double(turnaround) / process.serviceTime;
+                turnaroundSum += turnaround;
+                normTurnSum += normTurn;
+                ++finished;
+                appendInt(process.finishTime);
+                append(',');
+                appendInt(turnaround);
+                append(',');
+                appendDouble(normTurn);
+            } else {
+                append(",,");
             }
+            append('\n');
+            flushIfFull();
+        }
 
-            if (isExecuting) {
-                auto it = std::find_if(processes.begin(), processes.end(), [&](const Process& p) {
-                    return p.name == currentProcess.name;
-                });
-                size_t index = std::distance(processes.begin(), it);
-                timeline[index][currentTime] = '*';
-
-                --currentProcess.serviceTime;
-                --remainingQuantum;
-                
-                if (currentProcess.serviceTime == 0 || remainingQuantum == 0) {
-                    for (size_t i = 0; i < readyQueues.size(); ++i) {
-                        if (!readyQueues[i].empty() && readyQueues[i].front().name == currentProcess.name) {
-                            readyQueues[i].pop();
-                            if (remainingQuantum == 0 && currentProcess.serviceTime > 0) {
-                                size_t nextQueueIndex = i + 1;
-                                if (nextQueueIndex >= readyQueues.size()) {
-                                    readyQueues.emplace_back(); 
-                                }
-                                readyQueues[nextQueueIndex].push(currentProcess); 
-                            } else if (currentProcess.serviceTime == 0) {
-                                auto it = std::find_if(processes.begin(), processes.end(), [&](const Process& p) {
-                                    return p.name == currentProcess.name;
-                                });
-                                if (it != processes.end()) {
-                                    it->finishTime = currentTime + 1;
-                                }
-                            }
-                            break;
-                        }
-                    }
-                    isExecuting = false;
-                }
+        // Energy rows carry the value in the service column; the one without a process is the total.
+        for (size_t i = 0; i < energy.perProcess.size(); ++i) {
+            beginCsvRow("energy,");
+            appendCsvField(policy);
+            append(',');
+            appendCsvField(std::string(1, processes[i].name));
+            append(",,,,,");
+            appendDouble(energy.perProcess[i]);
+            append(",,,\n");
+        }
+        if (!energy.perProcess.empty()) {
+            beginCsvRow("energy,");
+            appendCsvField(policy);
+            append(",,,,,,");
+            appendDouble(energy.total);
+            append(",,,\n");
+        }
+
+        // Class rows carry the priority in the process column and the class means.
+        if (prioritized) {
+            for (const auto& c : priorityClassStats(processes)) {
+                beginCsvRow("class,");
+                appendCsvField(policy);
+                append(',');
+                appendInt(c.priority);
+                append(",,,,,,,");
+                appendDouble(c.meanTurnaround);
+                append(',');
+                appendDouble(c.meanNormTurn);
+                append('\n');
             }
-            ++currentTime;
         }
 
-        if (trace) {
-            displayTraceTimeline("FB-2i ", processes, timeline, simulationEnd);
+        // Means are over the finished processes; empty when none finished.
+        if (!processes.empty()) {
+            beginCsvRow("mean,");
+            appendCsvField(policy);
+            append(",,,,,,,,");
+            if (finished != 0) {
+                appendDouble(turnaroundSum / finished);
+                append(',');
+                appendDouble(normTurnSum / finished);
+            } else {
+                append(',');
+            }
+            append('\n');
         }
     }
-};
-
-// ----------------------------------------
-class Aging : public Policy {
-private:
-    int quantum;
 
 public:
-    void setQuantum(int q) {
-        quantum = q;    
-    }
+    ResultWriter(OutputFormat format, std::ostream& out, std::ostream& err) : format(format), out(out), err(err) {}
 
-    void executeTrace(int simulationEnd, bool trace) {
-        std::queue<Process> readyQueue;
-        std::vector<Process> runningQueue;
-        int currentTime = 0;
+    ~ResultWriter() {
+        flush();
+    }
 
-        std::vector<std::vector<char>> timeline(processes.size(), std::vector<char>(simulationEnd, ' '));
-        std::vector<bool> isInQueue(processes.size(), false);
+    static std::string csvHeaderLine(bool withScenario) {
+        return std::string(withScenario ? "scenario," : "") + "record,policy,process,start,end,state,arrival,service,finish,turnaround,normturn\n";
+    }
 
-        while (currentTime < simulationEnd) {
-        for (size_t i = 0; i < processes.size(); ++i) {
-            if (processes[i].arrivalTime <= currentTime && !isInQueue[i]) {
-                readyQueue.push(processes[i]);
-                isInQueue[i] = true;
-            }
-        }
+    OutputFormat getFormat() const {
+        return format;
+    }
 
+    std::ostream& stream() {
+        return out;
+    }
 
-        if (!readyQueue.empty()) {
-            Process currentProcess = readyQueue.front();
-            runningQueue.push_back(currentProcess);
+    std::ostream& errors() {
+        return err;
+    }
 
-            for (size_t i = 0; i < processes.size(); ++i) {
-            if (processes[i].arrivalTime <=  currentTime+quantum && !isInQueue[i]) {
-                readyQueue.push(processes[i]);
-                isInQueue[i] = true;
-            }
-        }
+    // Every run is also appended to traceFile when one is set.
+    void setTraceFile(TraceFileWriter* file) {
+        traceFile = file;
+    }
 
-            for (int t = 0; t < quantum; ++t) {
-                std::queue<Process> tempQueue = readyQueue; 
-                while (!tempQueue.empty()) {
-                    Process queuedProcess = tempQueue.front();
-                    tempQueue.pop();
+    // And written to chromeTrace as a Chrome trace-event process.
+    void setChromeTrace(ChromeTraceWriter* writer) {
+        chromeTrace = writer;
+    }
 
-                    auto queuedIt = std::find_if(processes.begin(), processes.end(), [&](const Process& p) {
-                        return p.name == queuedProcess.name;
-                    });
-                    size_t queuedIndex = std::distance(processes.begin(), queuedIt);
+    void recordTrace(const std::string& policy, const Policy& run, int simulationEnd) {
+        if (traceFile) {
+            traceFile->addRun(policy, run.getProcesses(), run.getTimeline(), simulationEnd);
+        }
+        if (chromeTrace) {
+            chromeTrace->addRun(policy, run.getProcesses(), run.getTimeline(), simulationEnd);
+        }
+    }
 
-                    if (currentTime + t >= processes[queuedIndex].arrivalTime && currentTime + t < simulationEnd) {   
-                        timeline[queuedIndex][currentTime + t] = '.';
-                    }
-                }
+    // Runs are looked up in and added to cache when one is set.
+    void setCache(ResultCache* resultCache) {
+        cache = resultCache;
+    }
 
-                auto it = std::find_if(processes.begin(), processes.end(), [&](const Process& p) {
-                    return p.name == currentProcess.name;
-                });
-                size_t index = std::distance(processes.begin(), it);
-                if (currentTime + t < simulationEnd) {
-                    timeline[index][currentTime + t] = '*';
-                }
-            }
+    ResultCache* getCache() const {
+        return cache;
+    }
 
-            currentTime += quantum;
-            std::queue<Process> p;
-            
-            while(!readyQueue.empty()) {
-                if(readyQueue.front() == currentProcess) {
-                    readyQueue.front().priority = currentProcess.initialPriority;
-                    p.push(readyQueue.front());
-                    readyQueue.pop();
-                }
-                else  {
-                    readyQueue.front().priority++;
-                    p.push(readyQueue.front());
-                    readyQueue.pop();
-                } 
-            }
+    // Policies run on the online engine under this speed model when one is set (--dvfs).
+    void setSpeedModel(const SpeedModel* model) {
+        speedModel = model;
+    }
 
-            while(!p.empty()) {
-                readyQueue.push(p.front());
-                p.pop();
-            }
-           
-            std::vector<Process> temp;
-            while (!readyQueue.empty()) {
-                temp.push_back(readyQueue.front());
-                readyQueue.pop();
-            }
+    const SpeedModel* getSpeedModel() const {
+        return speedModel;
+    }
 
-            std::sort(temp.begin(), temp.end(), [](const Process& a, const Process& b) {
-                return a.priority > b.priority; 
-            });
+    // Tags the output with a batch scenario ID: a "scenario" key in JSON, a leading column in CSV.
+    void setScenario(const std::string& id) {
+        scenarioId = id;
+    }
 
-            int highestPriority = temp[0].priority;
-            int i = 0;
-            std::vector<Process> conflictProcesses;
-            std::vector<Process> solvedProcesses;
-
-            while(temp.size() > 1 && temp[i].priority == highestPriority && temp[i].priority == temp[i+1].priority) {
-                conflictProcesses.push_back(temp[i]);
-                i++;
-            }
-            conflictProcesses.push_back(temp[i]);
-            
-            if(conflictProcesses.size() == 2) {
-                if(temp[0].priority == temp[1].priority) {
-                    for (int i = runningQueue.size() - 1; i >= 0; --i) {
-                        if(temp[0] == runningQueue[i]) {
-                            temp.push_back(temp[0]);
-                            temp.erase(temp.begin());
-                            break;
-                        } else if (temp[1] == runningQueue[i]) {
-                            break;
-                        }
-                    }
-                
-                }
-            } else {
-                int j;
-                if(temp[0].priority == temp[1].priority) {
-                    for (int i = runningQueue.size() - 1; i >= 0; --i) {
-                        for(auto& p1 : conflictProcesses) {
-                            if(p1 == runningQueue[i]) {
-                                j = 0;
-                                for(auto& p2 : solvedProcesses) {
-                                    if(p2.name == p1.name) {
-                                        j++;
-                                        break;
-                                    }
-                                }
-                                if(j == 0)
-                                    solvedProcesses.push_back(p1);
-                            }
-                        }
-                    }
-
-                    j = 0;
-                    for(int i = solvedProcesses.size() - 1; i >= 0; --i) {
-                        temp[j] = solvedProcesses[i];
-                        j++;
-                    }
-                }
-            }
-         
-            for (auto& process : temp) {
-                readyQueue.push(process);
+    // csvHeader is false for every batch scenario after the first, so the CSV keeps one header.
+    void begin(const std::string& mode, int simulationEnd, bool csvHeader = true) {
+        begun = true;
+        if (format == OutputFormat::Json) {
+            append('{');
+            if (!scenarioId.empty()) {
+                append("\"scenario\":");
+                appendJsonString(scenarioId);
+                append(',');
             }
+            append("\"mode\":");
+            appendJsonString(mode);
+            append(",\"simulationEnd\":");
+            appendInt(simulationEnd);
+            append(",\"runs\":[");
+        } else if (format == OutputFormat::Csv && csvHeader) {
+            append(csvHeaderLine(!scenarioId.empty()));
+        }
+    }
 
-        } else {
-            ++currentTime;
+    // hasStats is false for policies whose third input column is not a service time (Aging).
+    void writeRun(const std::string& policy, const Policy& run, bool hasStats) {
+        if (format == OutputFormat::Json) {
+            writeJsonRun(policy, run.getProcesses(), run.getTimeline(), run.getQuantumTrajectory(), run.getEnergy(), hasStats, run.prioritized());
+        } else if (format == OutputFormat::Csv) {
+            writeCsvRun(policy, run.getProcesses(), run.getTimeline(), run.getQuantumTrajectory(), run.getEnergy(), hasStats, run.prioritized());
         }
+        firstRun = false;
+        flushIfFull();
     }
 
-    if (trace) {
-        displayTraceTimeline("Aging " , processes, timeline, simulationEnd);
+    void end() {
+        if (format == OutputFormat::Json && begun) {
+            append("\n]}\n");
+        }
+        flush();
     }
+
+    void flush() {
+        if (!buffer.empty()) {
+            out.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+        out.flush();
     }
 };
 
-
 // ----------------------------------------
-void executePolicy1(std::vector<Process> processes, std::string mode, std::string policiesInput, int simulationEnd) {
-    if (policiesInput.find("1") != std::string::npos) {
-            FCFS fcfs;
-            for (const auto& process : processes) {
-                fcfs.addProcess(process);
-            }
+// Differential verification: the classes above are the reference behaviour. Any faster engine
+// is registered in candidateEngines() and must reproduce the reference timeline and finish
+// times exactly, including tie-breaks, before it can replace a reference policy.
+struct Workload {
+    std::string policy;
+    int simulationEnd = 0;
+    std::vector<Process> processes;
+};
 
-            if (mode == "trace") {
-                fcfs.executeTrace(simulationEnd,true);
-            } else if (mode == "stats") {
-                fcfs.executeTrace(simulationEnd,false);
-                fcfs.executeStats("FCFS");
-            } else {
-                std::cerr << "Error: Unknown mode " << mode << ".\n";
-            }
-        } else if (policiesInput.find("3") != std::string::npos) {
-            SPN spn;
-            for (const auto& process : processes) {
-                spn.addProcess(process);
-            }
+struct Schedule {
+    std::vector<std::vector<char>> timeline;
+    std::vector<int> finishTimes;
+};
 
-            if (mode == "trace") {
-                spn.executeTrace(simulationEnd,true);
-            } else if (mode == "stats") {
-                spn.executeTrace(simulationEnd,false);
-                spn.executeStats("SPN");
-            } else {
-                std::cerr << "Error: Unknown mode " << mode << ".\n";
-            }
-        } else if (policiesInput.find("4") != std::string::npos) {
-            SRT srt;
-            for (const auto& process : processes) {
-                srt.addProcess(process);
+struct CandidateEngine {
+    std::string name;
+    std::string policyId;
+    std::function<std::unique_ptr<Policy>(const std::string& policy)> create;
+    // Engines fed from an arrival stream only see processes in non-decreasing arrival order.
+    bool sortedArrivals = false;
+};
+
+std::vector<CandidateEngine> candidateEngines() {
+    std::vector<CandidateEngine> engines = {
+        {"fcfs-event", "1", [](const std::string&) { return std::unique_ptr<Policy>(new FCFSEvent()); }},
+    };
+    for (const char* id : {"1", "2", "3", "4", "5", "6", "7", "10", "11"}) {
+        engines.push_back({std::string("online-") + id, id,
+                           [](const std::string& policy) { return std::unique_ptr<Policy>(new OnlinePolicy(policy)); }, true});
+    }
+    return engines;
+}
+
+Schedule runSchedule(Policy& policy, const Workload& workload) {
+    for (const auto& process : workload.processes) {
+        policy.addProcess(process);
+    }
+    policy.executeTrace(workload.simulationEnd, false);
+
+    Schedule schedule;
+    schedule.timeline = policy.getTimeline();
+    for (const auto& process : policy.getProcesses()) {
+        schedule.finishTimes.push_back(process.finishTime);
+    }
+    return schedule;
+}
+
+Schedule runReference(const Workload& workload) {
+    std::string name;
+    std::unique_ptr<Policy> policy = createPolicy(workload.policy, name);
+    return runSchedule(*policy, workload);
+}
+
+// Empty when the schedules match, otherwise a description of the first difference.
+std::string compareSchedules(const Workload& workload, const Schedule& expected, const Schedule& actual) {
+    for (size_t i = 0; i < workload.processes.size(); ++i) {
+        char name = workload.processes[i].name;
+        for (int t = 0; t < workload.simulationEnd; ++t) {
+            if (expected.timeline[i][t] != actual.timeline[i][t]) {
+                return std::string("process ") + name + " differs at t=" + std::to_string(t) +
+                       ": expected '" + expected.timeline[i][t] + "', got '" + actual.timeline[i][t] + "'";
             }
+        }
+        if (expected.finishTimes[i] != actual.finishTimes[i]) {
+            return std::string("process ") + name + " finish: expected " + std::to_string(expected.finishTimes[i]) +
+                   ", got " + std::to_string(actual.finishTimes[i]);
+        }
+    }
+    return "";
+}
 
-            if (mode == "trace") {
-                srt.executeTrace(simulationEnd,true);
-            } else if (mode == "stats") {
-                srt.executeTrace(simulationEnd,false);
-                srt.executeStats("SRT");
-            } else {
-                std::cerr << "Error: Unknown mode " << mode << ".\n";
+bool isAgingPolicy(const std::string& policy) {
+    return policy[0] == '8';
+}
+
+std::string policyId(const std::string& policy) {
+    return policy.substr(0, policy.find('-'));
+}
+
+bool hasSortedArrivals(const Workload& workload) {
+    return std::is_sorted(workload.processes.begin(), workload.processes.end(), [](const Process& a, const Process& b) {
+        return a.arrivalTime < b.arrivalTime;
+    });
+}
+
+// Reorders processes by arrival (stable, so equal arrivals keep input order) and renames them A, B, ...
+Workload sortByArrival(Workload workload) {
+    std::stable_sort(workload.processes.begin(), workload.processes.end(), [](const Process& a, const Process& b) {
+        return a.arrivalTime < b.arrivalTime;
+    });
+    for (size_t i = 0; i < workload.processes.size(); ++i) {
+        workload.processes[i].name = 'A' + i;
+    }
+    return workload;
+}
+
+Workload randomWorkload(const std::string& policy, std::mt19937& rng) {
+    auto uniform = [&](int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(rng); };
+
+    Workload workload;
+    workload.policy = policy;
+    int numProcesses = uniform(1, 8);
+    int horizon = 0;
+    for (int i = 0; i < numProcesses; ++i) {
+        Process p;
+        p.name = 'A' + i;
+        p.arrivalTime = uniform(0, 12);
+        if (isAgingPolicy(policy)) {
+            p.initialPriority = p.priority = uniform(0, 5);
+            horizon = std::max(horizon, p.arrivalTime + 8);
+        } else {
+            p.serviceTime = uniform(1, 6);
+            horizon = std::max(horizon, p.arrivalTime) + p.serviceTime;
+            if (isPriorityPolicy(policy)) {
+                p.initialPriority = p.priority = uniform(0, 3);
             }
-        } else if (policiesInput.find("5") != std::string::npos) { 
-            HRRN hrrn;
-            for (const auto& process : processes) {
-                hrrn.addProcess(process);
+        }
+        workload.processes.push_back(p);
+    }
+    workload.simulationEnd = uniform(1, horizon + 2);
+    return workload;
+}
+
+// Greedily removes processes and lowers every number while the failure persists.
+Workload shrinkWorkload(Workload workload, const std::function<bool(const Workload&)>& fails) {
+    bool progress = true;
+    while (progress) {
+        progress = false;
+        auto attempt = [&](const Workload& smaller) {
+            if (fails(smaller)) {
+                workload = smaller;
+                progress = true;
+                return true;
+            }
+            return false;
+        };
+
+        for (size_t i = 0; i < workload.processes.size() && workload.processes.size() > 1; ++i) {
+            Workload smaller = workload;
+            smaller.processes.erase(smaller.processes.begin() + i);
+            for (size_t j = 0; j < smaller.processes.size(); ++j) {
+                smaller.processes[j].name = 'A' + j;
             }
+            if (attempt(smaller)) --i;
+        }
 
-            if (mode == "trace") {
-                hrrn.executeTrace(simulationEnd, true);
-            } else if (mode == "stats") {
-                hrrn.executeTrace(simulationEnd, false);
-                hrrn.executeStats("HRRN");
-            } else {
-                std::cerr << "Error: Unknown mode " << mode << ".\n";
+        while (workload.simulationEnd > 1) {
+            Workload smaller = workload;
+            --smaller.simulationEnd;
+            if (!attempt(smaller)) break;
+        }
+
+        size_t dash = workload.policy.find('-');
+        if (dash != std::string::npos && std::stoi(workload.policy.substr(dash + 1)) > 1) {
+            Workload smaller = workload;
+            smaller.policy = workload.policy.substr(0, dash + 1) + std::to_string(std::stoi(workload.policy.substr(dash + 1)) - 1);
+            attempt(smaller);
+        }
+
+        for (size_t i = 0; i < workload.processes.size(); ++i) {
+            int Process::*fields[] = {&Process::arrivalTime, &Process::serviceTime, &Process::initialPriority};
+            for (auto field : fields) {
+                int floor = field == &Process::serviceTime && !isAgingPolicy(workload.policy) ? 1 : 0;
+                while (workload.processes[i].*field > floor) {
+                    Workload smaller = workload;
+                    --(smaller.processes[i].*field);
+                    smaller.processes[i].priority = smaller.processes[i].initialPriority;
+                    if (!attempt(smaller)) break;
+                }
             }
-        } else if (policiesInput.find("6") != std::string::npos) { 
-            Feedback1 f1;
-            for (const auto& process : processes) {
-                f1.addProcess(process);
+        }
+    }
+    return workload;
+}
+
+void printWorkload(const Workload& workload) {
+    std::cout << "  trace\n  " << workload.policy << "\n  " << workload.simulationEnd << "\n  " << workload.processes.size() << "\n";
+    for (const auto& p : workload.processes) {
+        int third = isAgingPolicy(workload.policy) ? p.initialPriority : p.serviceTime;
+        std::cout << "  " << p.name << "," << p.arrivalTime << "," << third;
+        if (isPriorityPolicy(workload.policy)) std::cout << "," << p.initialPriority;
+        std::cout << "\n";
+    }
+}
+
+const std::vector<std::string> verifiedPolicies = {"1", "2-1", "2-3", "3", "4", "5", "6", "7", "8-1", "8-2", "9", "9-4",
+                                                   "10", "10-2", "11", "11-2"};
+
+bool multiCpuStreamIsLive();
+
+// Runs every candidate engine against the reference on random workloads.
+int runVerify(unsigned seed, int cases) {
+    std::mt19937 rng(seed);
+    int failures = 0, comparisons = 0;
+
+    for (const auto& engine : candidateEngines()) {
+        for (const auto& policy : verifiedPolicies) {
+            if (policyId(policy) != engine.policyId) {
+                continue;
             }
+            auto fails = [&](const Workload& w) {
+                if (engine.sortedArrivals && !hasSortedArrivals(w)) {
+                    return false;
+                }
+                std::unique_ptr<Policy> candidate = engine.create(w.policy);
+                return !compareSchedules(w, runReference(w), runSchedule(*candidate, w)).empty();
+            };
+
+            for (int c = 0; c < cases; ++c) {
+                Workload workload = randomWorkload(policy, rng);
+                if (engine.sortedArrivals) {
+                    workload = sortByArrival(workload);
+                }
+                ++comparisons;
+                if (!fails(workload)) {
+                    continue;
+                }
 
-            if (mode == "trace") {
-                f1.executeTrace(simulationEnd, true);
-            } else if (mode == "stats") {
-                f1.executeTrace(simulationEnd, false);
-                f1.executeStats("FB-1");
-            } else {
-                std::cerr << "Error: Unknown mode " << mode << ".\n";
+                ++failures;
+                Workload minimal = shrinkWorkload(workload, fails);
+                std::unique_ptr<Policy> candidate = engine.create(minimal.policy);
+                std::cout << engine.name << " diverges from policy " << policy << ": "
+                          << compareSchedules(minimal, runReference(minimal), runSchedule(*candidate, minimal))
+                          << "\nminimal input:\n";
+                printWorkload(minimal);
+                break;
             }
-        } else if (policiesInput.find("7") != std::string::npos) { 
-            Feedback2i f2i;
-            for (const auto& process : processes) {
-                f2i.addProcess(process);
+        }
+    }
+
+    ++comparisons;
+    if (!multiCpuStreamIsLive()) {
+        ++failures;
+        std::cout << "multi-CPU stream printed no window before the end of its input\n";
+    }
+
+    std::cout << "verify: " << comparisons << " comparisons, " << failures << " failures (seed " << seed << ")\n";
+    return failures == 0 ? 0 : 1;
+}
+
+// Golden corpus format, one block per case:
+//   case <policy> <simulationEnd>
+//   process <name>,<arrival>,<service or priority>[,<priority> for policies 10 and 11]
+//   row <name> <timeline with '_' for idle ticks> <finish time, 0 if unfinished>
+void writeGoldenCase(std::ostream& out, const Workload& workload, const Schedule& schedule) {
+    out << "case " << workload.policy << " " << workload.simulationEnd << "\n";
+    for (const auto& p : workload.processes) {
+        int third = isAgingPolicy(workload.policy) ? p.initialPriority : p.serviceTime;
+        out << "process " << p.name << "," << p.arrivalTime << "," << third;
+        if (isPriorityPolicy(workload.policy)) out << "," << p.initialPriority;
+        out << "\n";
+    }
+    for (size_t i = 0; i < workload.processes.size(); ++i) {
+        std::string row(schedule.timeline[i].begin(), schedule.timeline[i].end());
+        std::replace(row.begin(), row.end(), ' ', '_');
+        out << "row " << workload.processes[i].name << " " << row << " " << schedule.finishTimes[i] << "\n";
+    }
+    out << "\n";
+}
+
+int recordGolden(const std::string& path, unsigned seed, int cases) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Error: Cannot write golden corpus " << path << ".\n";
+        return 1;
+    }
+    out << "# Golden traces of the reference policies. Regenerate with: ./lab6 --record-golden " << path
+        << " --seed " << seed << " --cases " << cases << "\n\n";
+
+    std::mt19937 rng(seed);
+    for (const auto& policy : verifiedPolicies) {
+        for (int c = 0; c < cases; ++c) {
+            Workload workload = randomWorkload(policy, rng);
+            writeGoldenCase(out, workload, runReference(workload));
+        }
+    }
+    return 0;
+}
+
+// Replays the corpus through the reference policies and every matching candidate engine.
+int checkGolden(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Error: Cannot read golden corpus " << path << ".\n";
+        return 1;
+    }
+
+    int total = 0, failures = 0;
+    auto check = [&](const Workload& workload, const Schedule& expected) {
+        ++total;
+        std::string diff = compareSchedules(workload, expected, runReference(workload));
+        std::string engineName = "reference";
+        for (const auto& engine : candidateEngines()) {
+            if (!diff.empty() || policyId(workload.policy) != engine.policyId ||
+                (engine.sortedArrivals && !hasSortedArrivals(workload))) {
+                continue;
             }
+            std::unique_ptr<Policy> candidate = engine.create(workload.policy);
+            diff = compareSchedules(workload, expected, runSchedule(*candidate, workload));
+            engineName = engine.name;
+        }
+        if (!diff.empty()) {
+            ++failures;
+            std::cout << "golden case " << total << " (" << engineName << "): " << diff << "\ninput:\n";
+            printWorkload(workload);
+        }
+    };
 
-            if (mode == "trace") {
-                f2i.executeTrace(simulationEnd, true);
-            } else if (mode == "stats") {
-                f2i.executeTrace(simulationEnd, false);
-                f2i.executeStats("FB-2i");
+    Workload workload;
+    Schedule expected;
+    bool open = false;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream ss(line);
+        std::string tag;
+        ss >> tag;
+        if (tag == "case") {
+            if (open) check(workload, expected);
+            workload = Workload();
+            expected = Schedule();
+            ss >> workload.policy >> workload.simulationEnd;
+            open = true;
+        } else if (tag == "process") {
+            Process p;
+            char comma;
+            int third;
+            ss >> p.name >> comma >> p.arrivalTime >> comma >> third;
+            if (isAgingPolicy(workload.policy)) {
+                p.initialPriority = p.priority = third;
             } else {
-                std::cerr << "Error: Unknown mode " << mode << ".\n";
+                p.serviceTime = third;
+                if (ss >> comma >> p.initialPriority) p.priority = p.initialPriority;
             }
+            workload.processes.push_back(p);
+        } else if (tag == "row") {
+            char name;
+            std::string row;
+            int finish;
+            ss >> name >> row >> finish;
+            std::replace(row.begin(), row.end(), '_', ' ');
+            expected.timeline.emplace_back(row.begin(), row.end());
+            expected.finishTimes.push_back(finish);
+        }
+    }
+    if (open) check(workload, expected);
+
+    std::cout << "golden: " << total << " cases, " << failures << " failures\n";
+    return failures == 0 ? 0 : 1;
+}
+
+// ----------------------------------------
+void runPolicy(Policy& policy, const std::string& spec, const std::string& name, const std::vector<Process>& processes, const std::string& mode, int simulationEnd, ResultWriter& writer, bool hasStats = true) {
+    for (const auto& process : processes) {
+        policy.addProcess(process);
+    }
+
+    if (mode != "trace" && (mode != "stats" || !hasStats)) {
+        writer.errors() << "Error: Unknown mode " << mode << ".\n";
+        return;
+    }
+
+    policy.setOutput(writer.stream());
+    // Cached results do not carry energy, so runs under a speed model always simulate.
+    ResultCache* cache = writer.getSpeedModel() ? nullptr : writer.getCache();
+    SimulationResult result;
+    if (cache && cache->lookup(processes, spec, simulationEnd, result)) {
+        policy.restore(result);
+    } else {
+        policy.executeTrace(simulationEnd, false);
+        if (cache) {
+            result.policy = name;
+            result.simulationEnd = simulationEnd;
+            result.hasStats = hasStats;
+            result.processes = policy.getProcesses();
+            result.timeline = policy.getTimeline();
+            result.quantumTrajectory = policy.getQuantumTrajectory();
+            cache->store(processes, spec, simulationEnd, result);
+        }
+    }
+
+    if (writer.getFormat() != OutputFormat::Text) {
+        writer.writeRun(name, policy, hasStats);
+    } else if (mode == "trace") {
+        policy.displayTrace(simulationEnd);
+    } else {
+        policy.executeStats(name);
+    }
+    writer.recordTrace(name, policy, simulationEnd);
+}
+
+// --dvfs: runs a policy spec on the online engine under the writer's speed model.
+void runScaledPolicy(const std::string& spec, const std::vector<Process>& processes, const std::string& mode, int simulationEnd, ResultWriter& writer) {
+    std::string name;
+    if (!createPolicy(spec, name) || !OnlineScheduler(spec).isValid()) {
+        writer.errors() << "Error: Policy " << spec << " is not supported with --dvfs.\n";
+        return;
+    }
+    std::string label = name;
+    label.resize(std::max<size_t>(label.size() + 1, 6), ' ');
+    OnlinePolicy online(spec, label);
+    online.setSpeedModel(*writer.getSpeedModel());
+    runPolicy(online, spec, name, processes, mode, simulationEnd, writer);
+}
+
+// A policy given without a quantum: a single digit, or the priority policies 10 and 11.
+bool isPlainPolicyId(const std::string& policy) {
+    return policy.length() == 1 || policy == "10" || policy == "11";
+}
+
+void executePolicy1(std::vector<Process> processes, std::string mode, std::string policiesInput, int simulationEnd, ResultWriter& writer) {
+    if (writer.getSpeedModel()) {
+        runScaledPolicy(policiesInput, processes, mode, simulationEnd, writer);
+        return;
+    }
+    if (policiesInput == "10") {
+            PriorityScheduling prio(false, 0);
+            runPolicy(prio, policiesInput, "PRIO", processes, mode, simulationEnd, writer);
+        } else if (policiesInput == "11") {
+            PriorityScheduling o1(true, 1);
+            runPolicy(o1, policiesInput, "O1-1", processes, mode, simulationEnd, writer);
+        } else if (policiesInput.find("1") != std::string::npos) {
+            FCFS fcfs;
+            runPolicy(fcfs, policiesInput, "FCFS", processes, mode, simulationEnd, writer);
+        } else if (policiesInput.find("3") != std::string::npos) {
+            SPN spn;
+            runPolicy(spn, policiesInput, "SPN", processes, mode, simulationEnd, writer);
+        } else if (policiesInput.find("4") != std::string::npos) {
+            SRT srt;
+            runPolicy(srt, policiesInput, "SRT", processes, mode, simulationEnd, writer);
+        } else if (policiesInput.find("5") != std::string::npos) { 
+            HRRN hrrn;
+            runPolicy(hrrn, policiesInput, "HRRN", processes, mode, simulationEnd, writer);
+        } else if (policiesInput.find("6") != std::string::npos) { 
+            Feedback1 f1;
+            runPolicy(f1, policiesInput, "FB-1", processes, mode, simulationEnd, writer);
+        } else if (policiesInput.find("7") != std::string::npos) { 
+            Feedback2i f2i;
+            runPolicy(f2i, policiesInput, "FB-2i", processes, mode, simulationEnd, writer);
+        } else if (policiesInput.find("9") != std::string::npos) {
+            AdaptiveRoundRobin arr;
+            runPolicy(arr, policiesInput, "ARR", processes, mode, simulationEnd, writer);
         }
 }
 
-void executePolicy2(std::vector<Process> processes, std::string mode, std::string policiesInput, int simulationEnd) {
+void executePolicy2(std::vector<Process> processes, std::string mode, std::string policiesInput, int simulationEnd, ResultWriter& writer) {
+    if (writer.getSpeedModel()) {
+        runScaledPolicy(policiesInput, processes, mode, simulationEnd, writer);
+        return;
+    }
     char temp[policiesInput.length() + 1];
         strcpy(temp, policiesInput.c_str());
 
@@ -932,66 +1396,54 @@ void executePolicy2(std::vector<Process> processes, std::string mode, std::strin
 
             if (std::string(policy) == "2") {
                 RoundRobin rr;
-
-                for (const auto& process : processes) {
-                rr.addProcess(process);
-                }
-
                 rr.setQuantum(q);
-
-                if (mode == "trace") {
-                    rr.executeTrace(simulationEnd, true);
-                } else if (mode == "stats") {
-                    rr.executeTrace(simulationEnd, false);
-                    rr.executeStats("RR-" + std::string(quantum));
-                } else {
-                    std::cerr << "Error: Unknown mode " << mode << ".\n";
-                }
+                runPolicy(rr, policiesInput, "RR-" + std::string(quantum), processes, mode, simulationEnd, writer);
             } else if (std::string(policy) == "8") {
                 Aging aging;
-
-                for (const auto& process : processes) {
-                aging.addProcess(process);
-                }
-
                 aging.setQuantum(q);
-
-                if (mode == "trace") {
-                    aging.executeTrace(simulationEnd, true);
-                } else {
-                    std::cerr << "Error: Unknown mode " << mode << ".\n";
-                }
+                runPolicy(aging, policiesInput, "Aging", processes, mode, simulationEnd, writer, false);
+            } else if (std::string(policy) == "9") {
+                AdaptiveRoundRobin arr;
+                arr.setRoundTarget(q);
+                runPolicy(arr, policiesInput, "ARR-" + std::string(quantum), processes, mode, simulationEnd, writer);
+            } else if (std::string(policy) == "10") {
+                PriorityScheduling prio(false, q);
+                runPolicy(prio, policiesInput, q > 0 ? "PRIO-" + std::to_string(q) : "PRIO", processes, mode, simulationEnd, writer);
+            } else if (std::string(policy) == "11" && q > 0) {
+                PriorityScheduling o1(true, q);
+                runPolicy(o1, policiesInput, "O1-" + std::to_string(q), processes, mode, simulationEnd, writer);
             }
         }
 }
 
-int main() {
+// Reads one scenario (mode, policy list, horizon and processes) and runs it into the writer.
+int runScenario(std::istream& in, ResultWriter& writer, bool csvHeader = true) {
     std::string mode;
-    if (!(std::cin >> mode)) {
-        std::cerr << "Error: Failed to read mode from input.\n";
+    if (!(in >> mode)) {
+        writer.errors() << "Error: Failed to read mode from input.\n";
         return 1;
     }
 
     std::string policiesInput;
-    std::cin.ignore();
-    if (!std::getline(std::cin, policiesInput)) {
-        std::cerr << "Error: Failed to read policies from input.\n";
+    in.ignore();
+    if (!std::getline(in, policiesInput)) {
+        writer.errors() << "Error: Failed to read policies from input.\n";
         return 1;
     }
 
     int simulationEnd, numProcesses;
-    if (!(std::cin >> simulationEnd >> numProcesses)) {
-        std::cerr << "Error: Failed to read simulation end time or number of processes.\n";
+    if (!(in >> simulationEnd >> numProcesses)) {
+        writer.errors() << "Error: Failed to read simulation end time or number of processes.\n";
         return 1;
     }
 
-    std::cin.ignore();
+    in.ignore();
 
     std::vector<Process> processes;
     for (int i = 0; i < numProcesses; ++i) {
         std::string processLine;
-        if (!std::getline(std::cin, processLine)) {
-            std::cerr << "Error: Failed to read process line " << i + 1 << ".\n";
+        if (!std::getline(in, processLine)) {
+            writer.errors() << "Error: Failed to read process line " << i + 1 << ".\n";
             return 1;
         }
 
@@ -1001,13 +1453,21 @@ int main() {
         if(!(policiesInput.length() > 1 && policiesInput[0] == '8'))
         {
             if (!(ss >> p.name >> comma >> p.arrivalTime >> comma >> p.serviceTime)) {
-                std::cerr << "Error: Failed to parse process line " << i + 1 << ".\n";
+                writer.errors() << "Error: Failed to parse process line " << i + 1 << ".\n";
                 return 1;
             }
+            // Optional fourth column: the priority read by policies 10 and 11.
+            if (ss >> comma >> p.initialPriority) {
+                if (!isValidPriority(p.initialPriority)) {
+                    writer.errors() << "Error: Priority on process line " << i + 1 << " must be 0-" << priorityLevels - 1 << ".\n";
+                    return 1;
+                }
+                p.priority = p.initialPriority;
+            }
             processes.push_back(p);
         } else {
             if (!(ss >> p.name >> comma >> p.arrivalTime >> comma >> p.initialPriority)) {
-                std::cerr << "Error: Failed to parse process line " << i + 1 << ".\n";
+                writer.errors() << "Error: Failed to parse process line " << i + 1 << ".\n";
                 return 1;
             }
             p.priority = p.initialPriority;
@@ -1015,24 +1475,2034 @@ int main() {
         }
     }
 
-    if(policiesInput.length() == 1) {
-        executePolicy1(processes, mode, policiesInput, simulationEnd);
+    writer.begin(mode, simulationEnd, csvHeader);
+
+    if(isPlainPolicyId(policiesInput)) {
+        executePolicy1(processes, mode, policiesInput, simulationEnd, writer);
     } else if(policiesInput.length() == 3) {
-        executePolicy2(processes, mode, policiesInput, simulationEnd);
+        executePolicy2(processes, mode, policiesInput, simulationEnd, writer);
     } else if(policiesInput.length() > 3) {
         std::stringstream ss(policiesInput);
         std::string policy;
 
         while (std::getline(ss, policy, ',')) {
-            if(policy.length() == 1) {
-                executePolicy1(processes, mode, policy, simulationEnd);
+            if(isPlainPolicyId(policy)) {
+                executePolicy1(processes, mode, policy, simulationEnd, writer);
             } else {
-                executePolicy2(processes, mode, policy, simulationEnd);
+                executePolicy2(processes, mode, policy, simulationEnd, writer);
             }
         }
     } else {
-    std::cerr << "Error: Unknown Policy.\n";
+    writer.errors() << "Error: Unknown Policy.\n";
     return 1;
     }
     return 0;
 }
+
+// ----------------------------------------
+// Batch mode: a stream of records in the usual input format, each introduced by a
+// "scenario <id>" line. Records are simulated on worker threads and written back in input
+// order, tagged with their ID, while later records are still being read.
+struct ScenarioRecord {
+    size_t index;
+    std::string id;
+    std::string text;
+};
+
+struct ScenarioOutput {
+    std::string id;
+    std::string output;
+    std::string errors;
+};
+
+class ScenarioReader {
+private:
+    std::istream& in;
+    std::string nextId;
+    bool started = false;
+    size_t count = 0;
+
+    static bool isHeader(const std::string& line, std::string& id) {
+        if (line.compare(0, 9, "scenario ") != 0) {
+            return false;
+        }
+        size_t begin = line.find_first_not_of(' ', 9);
+        size_t end = line.find_last_not_of(" \r");
+        id = begin == std::string::npos ? "" : line.substr(begin, end - begin + 1);
+        return true;
+    }
+
+public:
+    explicit ScenarioReader(std::istream& in) : in(in) {}
+
+    bool next(ScenarioRecord& record) {
+        std::string line, id;
+        while (!started && std::getline(in, line)) {
+            started = isHeader(line, nextId);
+        }
+        if (!started) {
+            return false;
+        }
+
+        record.index = count++;
+        record.id = nextId;
+        record.text.clear();
+        started = false;
+        while (std::getline(in, line)) {
+            if (isHeader(line, nextId)) {
+                started = true;
+                break;
+            }
+            record.text += line;
+            record.text += '\n';
+        }
+        return true;
+    }
+};
+
+int runBatch(std::istream& in, OutputFormat format, unsigned jobs, ResultCache* cache, const SpeedModel* speedModel) {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<ScenarioRecord> pending;
+    std::map<size_t, ScenarioOutput> finished;
+    size_t readCount = 0, writtenCount = 0;
+    bool inputDone = false;
+    int status = 0;
+    const size_t window = jobs * 8;
+
+    auto worker = [&]() {
+        while (true) {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return !pending.empty() || inputDone; });
+            if (pending.empty()) {
+                return;
+            }
+            ScenarioRecord record = std::move(pending.front());
+            pending.pop_front();
+            lock.unlock();
+
+            // Every output record is tagged with its ID, so a record without one is not run.
+            if (record.id.empty()) {
+                lock.lock();
+                status = 1;
+                finished.emplace(record.index, ScenarioOutput{record.id, "",
+                                 "Error: Scenario " + std::to_string(record.index + 1) + " has an empty id; skipped.\n"});
+                changed.notify_all();
+                continue;
+            }
+
+            std::istringstream scenarioIn(record.text);
+            std::ostringstream out, err;
+            ResultWriter writer(format, out, err);
+            writer.setScenario(record.id);
+            writer.setCache(cache);
+            writer.setSpeedModel(speedModel);
+            int scenarioStatus = runScenario(scenarioIn, writer, false);
+            writer.end();
+
+            std::string errors;
+            std::istringstream errLines(err.str());
+            std::string line;
+            while (std::getline(errLines, line)) {
+                errors += "[" + record.id + "] " + line + "\n";
+            }
+
+            lock.lock();
+            if (scenarioStatus != 0) {
+                status = 1;
+            }
+            finished.emplace(record.index, ScenarioOutput{record.id, out.str(), std::move(errors)});
+            changed.notify_all();
+        }
+    };
+
+    auto emitter = [&]() {
+        bool firstJson = true;
+        if (format == OutputFormat::Json) {
+            std::cout << "[";
+        } else if (format == OutputFormat::Csv) {
+            std::cout << ResultWriter::csvHeaderLine(true);
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            changed.wait(lock, [&] { return finished.count(writtenCount) || (inputDone && writtenCount == readCount); });
+            auto it = finished.find(writtenCount);
+            if (it == finished.end()) {
+                break;
+            }
+            ScenarioOutput result = std::move(it->second);
+            finished.erase(it);
+            ++writtenCount;
+            changed.notify_all();
+            lock.unlock();
+
+            if (format == OutputFormat::Json) {
+                if (!result.output.empty()) {
+                    std::cout << (firstJson ? "\n" : ",\n") << result.output;
+                    firstJson = false;
+                }
+            } else if (format == OutputFormat::Csv) {
+                std::cout << result.output;
+            } else if (!result.id.empty()) {
+                std::cout << "scenario " << result.id << "\n" << result.output;
+            }
+            std::cerr << result.errors;
+            lock.lock();
+        }
+
+        if (format == OutputFormat::Json) {
+            std::cout << "]\n";
+        }
+        std::cout.flush();
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < jobs; ++i) {
+        workers.emplace_back(worker);
+    }
+    std::thread output(emitter);
+
+    ScenarioReader reader(in);
+    ScenarioRecord record;
+    while (reader.next(record)) {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] { return readCount - writtenCount < window; });
+        pending.push_back(std::move(record));
+        ++readCount;
+        changed.notify_all();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        inputDone = true;
+        changed.notify_all();
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    output.join();
+    return status;
+}
+
+// ----------------------------------------
+// Monte Carlo replications: a stochastic workload specification is sampled R times and every
+// replication is run through the reference policies. Each replication draws from its own
+// counter-based stream, so results do not depend on thread count or scheduling order.
+class CounterRng {
+private:
+    uint64_t key;
+    uint64_t counter = 0;
+
+    static uint64_t mix(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+public:
+    CounterRng(uint64_t seed, uint64_t stream) : key(mix(seed ^ mix(stream + 0x9E3779B97F4A7C15ULL))) {}
+
+    uint64_t next() {
+        return mix(key + (++counter) * 0x9E3779B97F4A7C15ULL);
+    }
+
+    // Uniform in (0, 1).
+    double uniform() {
+        return ((next() >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+    }
+};
+
+struct Distribution {
+    std::string kind = "constant";
+    double a = 1, b = 1;
+
+    double sample(CounterRng& rng) const {
+        if (kind == "exponential") return -a * std::log(rng.uniform());
+        if (kind == "uniform") return a + (b - a) * rng.uniform();
+        return a;
+    }
+};
+
+struct MonteCarloSpec {
+    std::vector<std::string> policies;
+    int numProcesses = 10;
+    Distribution interarrival;
+    Distribution service;
+    int replications = 1000;
+    int minReplications = 30;
+    double precision = 0;
+    double confidence = 0.95;
+    uint64_t seed = 1;
+};
+
+// Per-replication metrics of one policy.
+struct ReplicationMetrics {
+    double meanTurnaround;
+    double meanNormTurn;
+    double p95Turnaround;
+    double maxNormTurn;
+};
+
+static const int monteCarloMetrics = 4;
+static const int monteCarloRound = 64;
+static const char* monteCarloMetricNames[monteCarloMetrics] = {"MeanTurn", "NormTurn", "P95Turn", "MaxNorm"};
+static const char* monteCarloMetricKeys[monteCarloMetrics] = {"meanTurnaround", "meanNormTurn", "p95Turnaround", "maxNormTurn"};
+
+// Welford's online mean and variance: no cancellation between large sums over many replications.
+struct RunningStats {
+    int count = 0;
+    double mean = 0;
+    double squaredDeviations = 0;
+
+    void add(double value) {
+        ++count;
+        double delta = value - mean;
+        mean += delta / count;
+        squaredDeviations += delta * (value - mean);
+    }
+
+    double variance() const {
+        return count > 1 ? squaredDeviations / (count - 1) : 0;
+    }
+};
+
+double metricValue(const ReplicationMetrics& m, int metric) {
+    switch (metric) {
+        case 0: return m.meanTurnaround;
+        case 1: return m.meanNormTurn;
+        case 2: return m.p95Turnaround;
+        default: return m.maxNormTurn;
+    }
+}
+
+// Two-sided Student-t quantile: normal quantile (Abramowitz & Stegun 26.2.23) corrected by a
+// Cornish-Fisher expansion in the degrees of freedom.
+double studentQuantile(double confidence, int degrees) {
+    double p = 1 - (1 - confidence) / 2;
+    double q = std::sqrt(-2 * std::log(1 - p));
+    double z = q - (2.515517 + 0.802853 * q + 0.010328 * q * q) / (1 + 1.432788 * q + 0.189269 * q * q + 0.001308 * q * q * q);
+    double n = std::max(degrees, 1);
+    double z3 = z * z * z, z5 = z3 * z * z, z7 = z5 * z * z;
+    return z + (z3 + z) / (4 * n) + (5 * z5 + 16 * z3 + 3 * z) / (96 * n * n)
+             + (3 * z7 + 19 * z5 + 17 * z3 - 15 * z) / (384 * n * n * n);
+}
+
+std::vector<Process> sampleWorkload(const MonteCarloSpec& spec, uint64_t replication) {
+    CounterRng rng(spec.seed, replication);
+    std::vector<Process> processes;
+    double clock = 0;
+    for (int i = 0; i < spec.numProcesses; ++i) {
+        if (i > 0) {
+            clock += std::max(0.0, spec.interarrival.sample(rng));
+        }
+        Process p;
+        p.name = i < 26 ? 'A' + i : 'a' + (i - 26);
+        p.arrivalTime = static_cast<int>(clock);
+        p.serviceTime = std::max(1, static_cast<int>(std::ceil(spec.service.sample(rng))));
+        processes.push_back(p);
+    }
+    return processes;
+}
+
+ReplicationMetrics runReplication(const std::string& policySpec, const std::vector<Process>& workload) {
+    int simulationEnd = 1;
+    for (const auto& p : workload) {
+        simulationEnd = std::max(simulationEnd, p.arrivalTime) + p.serviceTime;
+    }
+
+    std::string name;
+    std::unique_ptr<Policy> policy = createPolicy(policySpec, name);
+    for (const auto& p : workload) {
+        policy->addProcess(p);
+    }
+    policy->executeTrace(simulationEnd, false);
+
+    std::vector<double> turnarounds;
+    ReplicationMetrics metrics = {0, 0, 0, 0};
+    for (const auto& p : policy->getProcesses()) {
+        double turnaround = p.finishTime - p.arrivalTime;
+        double normTurn = turnaround / p.serviceTime;
+        turnarounds.push_back(turnaround);
+        metrics.meanTurnaround += turnaround;
+        metrics.meanNormTurn += normTurn;
+        metrics.maxNormTurn = std::max(metrics.maxNormTurn, normTurn);
+    }
+    metrics.meanTurnaround /= turnarounds.size();
+    metrics.meanNormTurn /= turnarounds.size();
+    std::sort(turnarounds.begin(), turnarounds.end());
+    metrics.p95Turnaround = turnarounds[static_cast<size_t>(std::ceil(0.95 * turnarounds.size())) - 1];
+    return metrics;
+}
+
+bool parseMonteCarloSpec(std::istream& in, MonteCarloSpec& spec) {
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream ss(line.substr(0, line.find('#')));
+        std::string key;
+        if (!(ss >> key)) {
+            continue;
+        }
+        bool ok = true;
+        if (key == "policies") {
+            std::string list, policy;
+            ok = static_cast<bool>(ss >> list);
+            std::stringstream policies(list);
+            while (std::getline(policies, policy, ',')) {
+                spec.policies.push_back(policy);
+            }
+        } else if (key == "processes") {
+            ok = ss >> spec.numProcesses && spec.numProcesses >= 1 && spec.numProcesses <= 52;
+        } else if (key == "arrival" || key == "service") {
+            Distribution& d = key == "arrival" ? spec.interarrival : spec.service;
+            ok = static_cast<bool>(ss >> d.kind >> d.a);
+            d.b = d.a;
+            if (ok && d.kind == "uniform") ok = static_cast<bool>(ss >> d.b);
+            ok = ok && (d.kind == "constant" || d.kind == "exponential" || d.kind == "uniform");
+        } else if (key == "replications") {
+            ok = ss >> spec.replications && spec.replications >= 2;
+        } else if (key == "min-replications") {
+            ok = ss >> spec.minReplications && spec.minReplications >= 2;
+        } else if (key == "precision") {
+            ok = static_cast<bool>(ss >> spec.precision);
+        } else if (key == "confidence") {
+            ok = ss >> spec.confidence && spec.confidence > 0 && spec.confidence < 1;
+        } else if (key == "seed") {
+            ok = static_cast<bool>(ss >> spec.seed);
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "Error: Invalid Monte Carlo spec line: " << line << "\n";
+            return false;
+        }
+    }
+
+    for (const auto& policy : spec.policies) {
+        std::string name;
+        if (!createPolicy(policy, name) || isAgingPolicy(policy)) {
+            std::cerr << "Error: Policy " << policy << " cannot be replicated.\n";
+            return false;
+        }
+    }
+    if (spec.policies.empty()) {
+        std::cerr << "Error: Monte Carlo spec lists no policies.\n";
+        return false;
+    }
+    return true;
+}
+
+// JSON: one document with a "policies" array; CSV: one row per policy and metric.
+template <typename HalfWidth>
+void writeMonteCarlo(const MonteCarloSpec& spec, const std::vector<RunningStats>& stats, int done, bool converged,
+                     OutputFormat format, HalfWidth halfWidth) {
+    char number[64];
+    if (format == OutputFormat::Csv) {
+        std::cout << "policy,metric,mean,half_width,replications,confidence\n";
+    } else {
+        snprintf(number, sizeof(number), "%g", spec.confidence);
+        std::cout << "{\"replications\":" << done << ",\"converged\":" << (converged ? "true" : "false")
+                  << ",\"processes\":" << spec.numProcesses << ",\"confidence\":" << number << ",\"policies\":[";
+    }
+    for (size_t p = 0; p < spec.policies.size(); ++p) {
+        std::string name;
+        createPolicy(spec.policies[p], name);
+        if (format == OutputFormat::Json) {
+            std::cout << (p == 0 ? "\n" : ",\n") << "{\"policy\":\"" << name << "\"";
+        }
+        for (int m = 0; m < monteCarloMetrics; ++m) {
+            double mean = stats[p * monteCarloMetrics + m].mean, half = halfWidth(p, m);
+            if (format == OutputFormat::Json) {
+                snprintf(number, sizeof(number), "{\"mean\":%.6g,\"halfWidth\":%.6g}", mean, half);
+                std::cout << ",\"" << monteCarloMetricKeys[m] << "\":" << number;
+            } else {
+                snprintf(number, sizeof(number), "%.6g,%.6g,%d,%g", mean, half, done, spec.confidence);
+                std::cout << name << "," << monteCarloMetricKeys[m] << "," << number << "\n";
+            }
+        }
+        if (format == OutputFormat::Json) {
+            std::cout << "}";
+        }
+    }
+    if (format == OutputFormat::Json) {
+        std::cout << "\n]}\n";
+    }
+}
+
+int runMonteCarlo(std::istream& in, unsigned jobs, OutputFormat format) {
+    MonteCarloSpec spec;
+    if (!parseMonteCarloSpec(in, spec)) {
+        return 1;
+    }
+
+    size_t numPolicies = spec.policies.size();
+    // results[policy][replication], filled a round at a time in replication order.
+    std::vector<std::vector<ReplicationMetrics>> results(numPolicies);
+    std::vector<RunningStats> stats(numPolicies * monteCarloMetrics);
+    int done = 0;
+    bool converged = false;
+
+    auto halfWidth = [&](size_t policy, int metric) {
+        return studentQuantile(spec.confidence, done - 1) * std::sqrt(stats[policy * monteCarloMetrics + metric].variance() / done);
+    };
+
+    while (done < spec.replications && !converged) {
+        int roundEnd = std::min(spec.replications, done + monteCarloRound);
+        for (auto& policyResults : results) {
+            policyResults.resize(roundEnd);
+        }
+
+        std::atomic<int> nextReplication(done);
+        auto worker = [&]() {
+            for (int r = nextReplication++; r < roundEnd; r = nextReplication++) {
+                std::vector<Process> workload = sampleWorkload(spec, r);
+                for (size_t p = 0; p < numPolicies; ++p) {
+                    results[p][r] = runReplication(spec.policies[p], workload);
+                }
+            }
+        };
+        std::vector<std::thread> workers;
+        for (unsigned i = 1; i < jobs; ++i) {
+            workers.emplace_back(worker);
+        }
+        worker();
+        for (auto& thread : workers) {
+            thread.join();
+        }
+
+        for (; done < roundEnd; ++done) {
+            for (size_t p = 0; p < numPolicies; ++p) {
+                for (int m = 0; m < monteCarloMetrics; ++m) {
+                    stats[p * monteCarloMetrics + m].add(metricValue(results[p][done], m));
+                }
+            }
+        }
+
+        if (spec.precision > 0 && done >= spec.minReplications) {
+            converged = true;
+            for (size_t p = 0; p < numPolicies; ++p) {
+                if (halfWidth(p, 0) > spec.precision * stats[p * monteCarloMetrics].mean) {
+                    converged = false;
+                }
+            }
+        }
+    }
+
+    if (format != OutputFormat::Text) {
+        writeMonteCarlo(spec, stats, done, converged, format, halfWidth);
+        return 0;
+    }
+
+    std::cout << "Monte Carlo: " << done << " replications" << (converged ? " (precision reached)" : "")
+              << ", " << spec.numProcesses << " processes each, "
+              << std::fixed << std::setprecision(0) << spec.confidence * 100 << "% confidence intervals\n";
+    std::cout << "Policy  ";
+    for (int m = 0; m < monteCarloMetrics; ++m) {
+        std::cout << "|" << std::setw(18) << monteCarloMetricNames[m] << " ";
+    }
+    std::cout << "|\n";
+
+    std::cout << std::setprecision(2);
+    for (size_t p = 0; p < numPolicies; ++p) {
+        std::string name;
+        createPolicy(spec.policies[p], name);
+        std::cout << std::left << std::setw(8) << name << std::right;
+        for (int m = 0; m < monteCarloMetrics; ++m) {
+            std::cout << "|" << std::setw(9) << stats[p * monteCarloMetrics + m].mean << " +- " << std::setw(5) << halfWidth(p, m) << " ";
+        }
+        std::cout << "|\n";
+    }
+    return 0;
+}
+
+// ----------------------------------------
+// Streaming mode: arrivals are read from stdin as they come ("name,arrival,service" per line,
+// arrivals non-decreasing) and metrics are reported for every window of simulated time.
+class StreamArrivalSource : public ArrivalSource {
+private:
+    std::istream& in;
+    int64_t lastArrival = 0;
+    uint64_t lineNumber = 0;
+
+public:
+    explicit StreamArrivalSource(std::istream& in) : in(in) {}
+
+    bool next(OnlineJob& job) override {
+        std::string line;
+        while (std::getline(in, line)) {
+            ++lineNumber;
+            if (line.empty() || line[0] == '#' || line == "\r") {
+                continue;
+            }
+            size_t first = line.find(','), second = line.find(',', first + 1);
+            size_t third = second == std::string::npos ? std::string::npos : line.find(',', second + 1);
+            const char* end = line.data() + (third == std::string::npos ? line.size() : third);
+            job.priority = 0;
+            if (first == std::string::npos || second == std::string::npos ||
+                std::from_chars(line.data() + first + 1, line.data() + second, job.arrival).ec != std::errc() ||
+                std::from_chars(line.data() + second + 1, end, job.service).ec != std::errc() || job.service <= 0 ||
+                (third != std::string::npos &&
+                 (std::from_chars(line.data() + third + 1, line.data() + line.size(), job.priority).ec != std::errc() ||
+                  !isValidPriority(job.priority)))) {
+                std::cerr << "Error: Failed to parse arrival line " << lineNumber << ".\n";
+                continue;
+            }
+            if (job.arrival < lastArrival) {
+                std::cerr << "Error: Arrival line " << lineNumber << " goes back in time; skipped.\n";
+                continue;
+            }
+            job.name = line.substr(0, first);
+            lastArrival = job.arrival;
+            return true;
+        }
+        return false;
+    }
+};
+
+// Log-linear histogram with 1/32 relative resolution: constant memory for any number of samples.
+class LogHistogram {
+private:
+    static const int exact = 64;
+    static const int subBuckets = 32;
+    std::vector<uint64_t> counts = std::vector<uint64_t>(exact + 58 * subBuckets, 0);
+    uint64_t total = 0;
+
+    static size_t bucket(uint64_t value) {
+        if (value < exact) {
+            return value;
+        }
+        int msb = 63 - __builtin_clzll(value);
+        int shift = msb - 5;
+        return exact + (msb - 6) * subBuckets + ((value >> shift) & (subBuckets - 1));
+    }
+
+    static double bucketMidpoint(size_t index) {
+        if (index < exact) {
+            return static_cast<double>(index);
+        }
+        int msb = static_cast<int>((index - exact) / subBuckets) + 6;
+        uint64_t sub = (index - exact) % subBuckets;
+        double low = std::ldexp(double(subBuckets + sub), msb - 5);
+        return low + std::ldexp(0.5, msb - 5);
+    }
+
+public:
+    void add(uint64_t value, uint64_t count = 1) {
+        counts[bucket(value)] += count;
+        total += count;
+    }
+
+    uint64_t count() const {
+        return total;
+    }
+
+    double percentile(double p) const {
+        if (total == 0) {
+            return 0;
+        }
+        uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(p * total)));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return bucketMidpoint(i);
+            }
+        }
+        return bucketMidpoint(counts.size() - 1);
+    }
+
+    void merge(const LogHistogram& other) {
+        for (size_t i = 0; i < counts.size(); ++i) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+    }
+
+    void clear() {
+        std::fill(counts.begin(), counts.end(), 0);
+        total = 0;
+    }
+};
+
+// Metrics of one window of simulated time. Windows of the same span from several CPUs merge
+// into one: areas, busy time, completions and jobs in the system add up.
+struct WindowSummary {
+    int64_t start = 0;
+    int64_t end = 0;
+    double queueArea = 0;
+    int64_t busyTicks = 0;
+    size_t inSystem = 0;
+    LogHistogram turnarounds;
+
+    void merge(const WindowSummary& other) {
+        queueArea += other.queueArea;
+        busyTicks += other.busyTicks;
+        inSystem += other.inSystem;
+        turnarounds.merge(other.turnarounds);
+    }
+};
+
+class WindowPrinter {
+private:
+    OutputFormat format;
+    std::ostream& out;
+    int cpus;
+    bool headerWritten = false;
+
+public:
+    WindowPrinter(OutputFormat format, std::ostream& out, int cpus = 1) : format(format), out(out), cpus(cpus) {}
+
+    void print(const WindowSummary& summary) {
+        double span = double(summary.end - summary.start);
+        uint64_t completed = summary.turnarounds.count();
+        const LogHistogram& turnarounds = summary.turnarounds;
+        double values[] = {completed / span, summary.queueArea / span, summary.busyTicks / (span * cpus),
+                           turnarounds.percentile(0.5), turnarounds.percentile(0.95), turnarounds.percentile(0.99)};
+        long long windowStart = summary.start, windowEnd = summary.end;
+        size_t inSystem = summary.inSystem;
+
+        char line[256];
+        if (format == OutputFormat::Json) {
+            snprintf(line, sizeof(line),
+                     "{\"windowStart\":%lld,\"windowEnd\":%lld,\"completed\":%llu,\"throughput\":%.4f,\"meanQueue\":%.3f,"
+                     "\"utilization\":%.3f,\"inSystem\":%zu,\"turnaroundP50\":%.1f,\"turnaroundP95\":%.1f,\"turnaroundP99\":%.1f}\n",
+                     windowStart, windowEnd, (unsigned long long)completed, values[0], values[1],
+                     values[2], inSystem, values[3], values[4], values[5]);
+        } else if (format == OutputFormat::Csv) {
+            if (!headerWritten) {
+                out << "window_start,window_end,completed,throughput,mean_queue,utilization,in_system,turnaround_p50,turnaround_p95,turnaround_p99\n";
+                headerWritten = true;
+            }
+            snprintf(line, sizeof(line), "%lld,%lld,%llu,%.4f,%.3f,%.3f,%zu,%.1f,%.1f,%.1f\n",
+                     windowStart, windowEnd, (unsigned long long)completed, values[0], values[1],
+                     values[2], inSystem, values[3], values[4], values[5]);
+        } else {
+            snprintf(line, sizeof(line),
+                     "window %lld-%lld  completed %llu  throughput %.4f  queue %.3f  util %.3f  in-system %zu  turnaround p50 %.1f p95 %.1f p99 %.1f\n",
+                     windowStart, windowEnd, (unsigned long long)completed, values[0], values[1],
+                     values[2], inSystem, values[3], values[4], values[5]);
+        }
+        out << line << std::flush;
+    }
+};
+
+// Cuts the engine's events into windows of simulated time and hands each closed window to sink.
+class WindowMetrics : public OnlineObserver {
+private:
+    int64_t window;
+    std::function<void(const WindowSummary&)> sink;
+    WindowSummary current;
+
+    void emit(int64_t windowEnd) {
+        current.end = windowEnd;
+        sink(current);
+        current.start = windowEnd;
+        current.queueArea = 0;
+        current.busyTicks = 0;
+        current.turnarounds.clear();
+    }
+
+    // Emits every window that ends at or before time t.
+    void advanceTo(int64_t t) {
+        while (t >= current.start + window) {
+            emit(current.start + window);
+        }
+    }
+
+public:
+    WindowMetrics(int64_t window, std::function<void(const WindowSummary&)> sink) : window(window), sink(std::move(sink)) {}
+
+    void onInterval(int64_t from, int64_t to, size_t waiting, bool busy) override {
+        current.inSystem = waiting + (busy ? 1 : 0);
+        while (from < to) {
+            advanceTo(from);
+            int64_t end = std::min(to, current.start + window);
+            current.queueArea += double(waiting) * (end - from);
+            current.busyTicks += busy ? end - from : 0;
+            from = end;
+        }
+    }
+
+    // A job finishing at time t completed during tick t-1, so it belongs to that tick's window.
+    void onFinish(const OnlineJob& job, int64_t time) override {
+        advanceTo(time - 1);
+        current.turnarounds.add(static_cast<uint64_t>(time - job.arrival));
+        current.inSystem = current.inSystem > 0 ? current.inSystem - 1 : 0;
+    }
+
+    void close(int64_t time) {
+        advanceTo(time);
+        if (time > current.start) {
+            emit(time);
+        }
+    }
+};
+
+// Turnaround and waiting time per priority, for streams run under policies 10 and 11: tails and
+// the longest wait of each class show starvation that the merged windows average away.
+class ClassMetrics : public OnlineObserver {
+private:
+    struct Class {
+        LogHistogram turnarounds;
+        double turnaroundSum = 0;
+        int64_t maxTurnaround = 0;
+        int64_t maxWait = 0;
+    };
+    std::map<int, Class, std::greater<int>> classes;
+
+public:
+    void onFinish(const OnlineJob& job, int64_t time) override {
+        Class& c = classes[job.priority];
+        int64_t turnaround = time - job.arrival;
+        c.turnarounds.add(static_cast<uint64_t>(turnaround));
+        c.turnaroundSum += double(turnaround);
+        c.maxTurnaround = std::max(c.maxTurnaround, turnaround);
+        c.maxWait = std::max(c.maxWait, turnaround - job.service);
+    }
+
+    void merge(const ClassMetrics& other) {
+        for (const auto& [priority, from] : other.classes) {
+            Class& c = classes[priority];
+            c.turnarounds.merge(from.turnarounds);
+            c.turnaroundSum += from.turnaroundSum;
+            c.maxTurnaround = std::max(c.maxTurnaround, from.maxTurnaround);
+            c.maxWait = std::max(c.maxWait, from.maxWait);
+        }
+    }
+
+    void print(OutputFormat format, std::ostream& out) const {
+        if (format == OutputFormat::Csv) {
+            out << "class,completed,mean_turnaround,turnaround_p50,turnaround_p95,turnaround_p99,max_turnaround,max_wait\n";
+        }
+        for (const auto& [priority, c] : classes) {
+            unsigned long long completed = c.turnarounds.count();
+            double values[] = {c.turnaroundSum / double(completed), c.turnarounds.percentile(0.5),
+                               c.turnarounds.percentile(0.95), c.turnarounds.percentile(0.99)};
+            long long maxTurnaround = c.maxTurnaround, maxWait = c.maxWait;
+            char line[256];
+            if (format == OutputFormat::Json) {
+                snprintf(line, sizeof(line),
+                         "{\"class\":%d,\"completed\":%llu,\"meanTurnaround\":%.3f,\"turnaroundP50\":%.1f,\"turnaroundP95\":%.1f,"
+                         "\"turnaroundP99\":%.1f,\"maxTurnaround\":%lld,\"maxWait\":%lld}\n",
+                         priority, completed, values[0], values[1], values[2], values[3], maxTurnaround, maxWait);
+            } else if (format == OutputFormat::Csv) {
+                snprintf(line, sizeof(line), "%d,%llu,%.3f,%.1f,%.1f,%.1f,%lld,%lld\n",
+                         priority, completed, values[0], values[1], values[2], values[3], maxTurnaround, maxWait);
+            } else {
+                snprintf(line, sizeof(line),
+                         "class %d  completed %llu  turnaround mean %.3f p50 %.1f p95 %.1f p99 %.1f max %lld  wait max %lld\n",
+                         priority, completed, values[0], values[1], values[2], values[3], maxTurnaround, maxWait);
+            }
+            out << line;
+        }
+        out << std::flush;
+    }
+};
+
+// Records the time of the last event so the final partial window can be closed.
+class StreamClock : public OnlineObserver {
+public:
+    OnlineObserver& inner;
+    int64_t now = 0;
+
+    explicit StreamClock(OnlineObserver& inner) : inner(inner) {}
+
+    void onArrival(const OnlineJob& job) override { inner.onArrival(job); }
+    void onSlice(const OnlineJob& job, int64_t start, int64_t end) override { inner.onSlice(job, start, end); }
+    void onFinish(const OnlineJob& job, int64_t time) override {
+        now = std::max(now, time);
+        inner.onFinish(job, time);
+    }
+    void onInterval(int64_t from, int64_t to, size_t waiting, bool busy) override {
+        now = std::max(now, to);
+        inner.onInterval(from, to, waiting, busy);
+    }
+};
+
+// Passes every engine event on to each of its targets in order.
+class ObserverFanout : public OnlineObserver {
+public:
+    std::vector<OnlineObserver*> targets;
+
+    void onArrival(const OnlineJob& job) override {
+        for (auto* target : targets) target->onArrival(job);
+    }
+    void onSlice(const OnlineJob& job, int64_t start, int64_t end) override {
+        for (auto* target : targets) target->onSlice(job, start, end);
+    }
+    void onFinish(const OnlineJob& job, int64_t time) override {
+        for (auto* target : targets) target->onFinish(job, time);
+    }
+    void onInterval(int64_t from, int64_t to, size_t waiting, bool busy) override {
+        for (auto* target : targets) target->onInterval(from, to, waiting, busy);
+    }
+};
+
+int runStream(std::istream& in, const std::string& policy, int64_t window, OutputFormat format, ChromeTraceWriter* chromeTrace) {
+    OnlineScheduler scheduler(policy);
+    if (!scheduler.isValid() || window <= 0) {
+        std::cerr << "Error: Streaming mode needs a policy 1, 2-q, 3-7, 10 or 11 and a positive window.\n";
+        return 1;
+    }
+
+    StreamArrivalSource source(in);
+    WindowPrinter printer(format, std::cout);
+    WindowMetrics metrics(window, [&](const WindowSummary& summary) { printer.print(summary); });
+    ObserverFanout observers;
+    observers.targets.push_back(&metrics);
+    ClassMetrics classMetrics;
+    if (isPriorityPolicy(policy)) {
+        observers.targets.push_back(&classMetrics);
+    }
+    std::unique_ptr<ChromeTraceObserver> chromeObserver;
+    if (chromeTrace) {
+        chromeObserver = std::make_unique<ChromeTraceObserver>(*chromeTrace, "stream " + policy);
+        observers.targets.push_back(chromeObserver.get());
+    }
+    StreamClock clock(observers);
+    scheduler.run(source, clock);
+    metrics.close(clock.now);
+    if (isPriorityPolicy(policy)) {
+        classMetrics.print(format, std::cout);
+    }
+    if (chromeObserver) chromeObserver->close();
+    return 0;
+}
+
+// ----------------------------------------
+// Multi-CPU streaming: an open system of several CPUs, each with its own run queue, simulated
+// as logical processes that only talk through channels:
+//
+//   reader/dispatcher --jobs--> CPU 0..N-1 (one OnlineScheduler each) --windows--> collector
+//
+// The dispatcher assigns every arrival to a CPU from the arrivals alone, so the graph has no
+// cycles, and the CPUs never send each other events, so there is nothing to synchronize them on
+// and no lookahead is needed. A CPU asks its channel for the next arrival before it simulates
+// past it and blocks until that job, a null message bounding its arrival, or the end of input is
+// there. Null messages only keep the run live: they tell a CPU that gets few jobs how far the
+// input has advanced, so it does not hold back the windows of live input. The collector merges
+// window w once every CPU has closed it or finished. Each CPU's schedule depends only on the jobs it was
+// given, so the output is the same whether the processes run on one thread or one thread each.
+enum class DispatchRule { RoundRobin, LeastWork };
+
+// Blocking FIFO between two logical processes; capacity 0 means unbounded.
+template <typename T>
+class Channel {
+private:
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<T> items;
+    size_t capacity;
+    bool closed = false;
+
+public:
+    explicit Channel(size_t capacity = 0) : capacity(capacity) {}
+
+    void push(T item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] { return capacity == 0 || items.size() < capacity; });
+        items.push_back(std::move(item));
+        changed.notify_all();
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        changed.notify_all();
+    }
+
+    // Waits for the next item; false once the channel is closed and drained.
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] { return !items.empty() || closed; });
+        if (items.empty()) {
+            return false;
+        }
+        item = std::move(items.front());
+        items.pop_front();
+        changed.notify_all();
+        return true;
+    }
+};
+
+// Jobs travel in batches so a channel operation is paid once per batch, not once per job.
+using JobBatch = std::vector<OnlineJob>;
+
+class ChannelArrivalSource : public ArrivalSource {
+private:
+    Channel<JobBatch>& channel;
+    JobBatch batch;
+    size_t position = 0;
+
+public:
+    explicit ChannelArrivalSource(Channel<JobBatch>& channel) : channel(channel) {}
+
+    bool next(OnlineJob& job) override {
+        while (position == batch.size()) {
+            position = 0;
+            if (!channel.pop(batch)) {
+                batch.clear();
+                return false;
+            }
+        }
+        job = std::move(batch[position++]);
+        return true;
+    }
+};
+
+class Dispatcher {
+private:
+    std::vector<Channel<JobBatch>*> cpus;
+    DispatchRule rule;
+    std::vector<JobBatch> batches;
+    std::vector<int64_t> backlog;  // unfinished work of each CPU at backlogTime
+    int64_t backlogTime = 0;
+    std::vector<int64_t> promised;  // time up to which each CPU has been told every arrival
+    int64_t lastArrival = 0;
+    int64_t window;
+    uint64_t count = 0;
+    static const size_t batchSize = 512;
+
+public:
+    Dispatcher(std::vector<Channel<JobBatch>*> cpus, DispatchRule rule, int64_t window)
+        : cpus(std::move(cpus)), rule(rule), batches(this->cpus.size()), backlog(this->cpus.size(), 0),
+          promised(this->cpus.size(), 0), window(window) {}
+
+    // Every supported policy is work-conserving, so a CPU's unfinished work at time t is known
+    // without asking it: the work it was given minus the ticks elapsed, never below zero.
+    size_t choose(const OnlineJob& job) {
+        if (rule == DispatchRule::RoundRobin) {
+            return count % cpus.size();
+        }
+        int64_t elapsed = job.arrival - backlogTime;
+        backlogTime = job.arrival;
+        size_t best = 0;
+        for (size_t i = 0; i < backlog.size(); ++i) {
+            backlog[i] = std::max<int64_t>(0, backlog[i] - elapsed);
+            if (backlog[i] < backlog[best]) {
+                best = i;
+            }
+        }
+        backlog[best] += job.service;
+        return best;
+    }
+
+    void route(OnlineJob& job) {
+        size_t cpu = choose(job);
+        ++count;
+        lastArrival = job.arrival;
+        promised[cpu] = job.arrival;
+        batches[cpu].push_back(std::move(job));
+        if (batches[cpu].size() == batchSize) {
+            cpus[cpu]->push(std::move(batches[cpu]));
+            batches[cpu] = JobBatch();
+            batches[cpu].reserve(batchSize);
+        }
+    }
+
+    // Sends the partial batches, and a null message promising no arrival before lastArrival to
+    // every CPU that has not heard of lastArrival's window, so each can close the windows up to
+    // the input read so far. A CPU's output only moves at window ends, so input that arrives a
+    // line at a time costs at most one null message per CPU and window, not one per line.
+    void flush() {
+        for (size_t i = 0; i < cpus.size(); ++i) {
+            if (promised[i] / window < lastArrival / window) {
+                OnlineJob bound;
+                bound.arrival = lastArrival;
+                bound.timeBound = true;
+                batches[i].push_back(std::move(bound));
+                promised[i] = lastArrival;
+            }
+            if (!batches[i].empty()) {
+                cpus[i]->push(std::move(batches[i]));
+                batches[i] = JobBatch();
+            }
+        }
+    }
+
+    void finish() {
+        for (size_t i = 0; i < cpus.size(); ++i) {
+            if (!batches[i].empty()) {
+                cpus[i]->push(std::move(batches[i]));
+            }
+            cpus[i]->close();
+        }
+    }
+};
+
+void runCpu(const std::string& policy, int64_t window, Channel<JobBatch>& in, Channel<WindowSummary>& out,
+            ClassMetrics& classes) {
+    OnlineScheduler scheduler(policy);
+    ChannelArrivalSource source(in);
+    WindowMetrics metrics(window, [&](const WindowSummary& summary) { out.push(summary); });
+    ObserverFanout observers;
+    observers.targets.push_back(&metrics);
+    if (isPriorityPolicy(policy)) {
+        observers.targets.push_back(&classes);
+    }
+    StreamClock clock(observers);
+    scheduler.run(source, clock);
+    metrics.close(clock.now);
+    out.close();
+}
+
+// Merges the CPUs' windows in time order. Every CPU closes the same windows from time 0 until it
+// goes quiet, the last one cut short at its final event, so the k-th window of each CPU covers the
+// same span and the merged window ends where the longest of them ends.
+void collectWindows(std::vector<std::unique_ptr<Channel<WindowSummary>>>& cpus, WindowPrinter& printer) {
+    std::vector<bool> running(cpus.size(), true);
+    while (true) {
+        WindowSummary merged, next;
+        bool any = false;
+        for (size_t i = 0; i < cpus.size(); ++i) {
+            if (!running[i]) {
+                continue;
+            }
+            if (!cpus[i]->pop(next)) {
+                running[i] = false;
+                continue;
+            }
+            if (!any) {
+                merged.start = next.start;
+                any = true;
+            }
+            merged.end = std::max(merged.end, next.end);
+            merged.merge(next);
+        }
+        if (!any) {
+            return;
+        }
+        printer.print(merged);
+    }
+}
+
+// With jobs == 1 the logical processes run one after another on this thread (the dispatcher
+// buffers the whole input); otherwise each gets its own thread and bounded input channels.
+int runMultiCpuStream(std::istream& in, std::ostream& out, const std::string& policy, int cpus, DispatchRule rule,
+                      int64_t window, OutputFormat format, unsigned jobs) {
+    if (!OnlineScheduler(policy).isValid() || window <= 0 || cpus <= 0) {
+        std::cerr << "Error: Multi-CPU streaming needs a policy 1, 2-q, 3-7, 10 or 11, a positive window and --cpus N >= 1.\n";
+        return 1;
+    }
+    const bool parallel = jobs > 1;
+    std::vector<std::unique_ptr<Channel<JobBatch>>> inputs;
+    std::vector<std::unique_ptr<Channel<WindowSummary>>> outputs;
+    std::vector<Channel<JobBatch>*> targets;
+    std::vector<ClassMetrics> classes(cpus);
+    for (int i = 0; i < cpus; ++i) {
+        inputs.push_back(std::make_unique<Channel<JobBatch>>(parallel ? 64 : 0));
+        outputs.push_back(std::make_unique<Channel<WindowSummary>>());
+        targets.push_back(inputs.back().get());
+    }
+
+    Dispatcher dispatcher(targets, rule, window);
+    // Live input must not wait for full batches: whenever reading on would block, what has been
+    // read so far goes out.
+    auto dispatch = [&]() {
+        StreamArrivalSource source(in);
+        OnlineJob job;
+        while (true) {
+            if (parallel && in.rdbuf()->in_avail() <= 0) {
+                dispatcher.flush();
+            }
+            if (!source.next(job)) {
+                break;
+            }
+            dispatcher.route(job);
+        }
+        dispatcher.finish();
+    };
+    WindowPrinter printer(format, out, cpus);
+
+    if (!parallel) {
+        dispatch();
+        for (int i = 0; i < cpus; ++i) {
+            runCpu(policy, window, *inputs[i], *outputs[i], classes[i]);
+        }
+        collectWindows(outputs, printer);
+    } else {
+        std::thread reader(dispatch);
+        std::vector<std::thread> workers;
+        for (int i = 0; i < cpus; ++i) {
+            workers.emplace_back(runCpu, policy, window, std::ref(*inputs[i]), std::ref(*outputs[i]), std::ref(classes[i]));
+        }
+        collectWindows(outputs, printer);
+        reader.join();
+        for (auto& thread : workers) {
+            thread.join();
+        }
+    }
+
+    if (isPriorityPolicy(policy)) {
+        for (int i = 1; i < cpus; ++i) {
+            classes[0].merge(classes[i]);
+        }
+        classes[0].print(format, out);
+    }
+    return 0;
+}
+
+// Checks that a multi-CPU stream stays live on input that is still open. Least-work dispatch
+// sends every job here to CPU 0, so CPU 1 only learns how far time has moved from null messages.
+// The dispatcher is flushed as the reader would be before blocking, the channels are then closed
+// on exactly what was sent, and CPU 1 must close every window before the last arrival.
+bool multiCpuStreamIsLive() {
+    const int64_t window = 10, lastArrival = 40;
+    Channel<JobBatch> busy, idle;
+    Dispatcher dispatcher({&busy, &idle}, DispatchRule::LeastWork, window);
+    for (int64_t arrival = 0; arrival <= lastArrival; arrival += window) {
+        OnlineJob job;
+        job.name = "j";
+        job.arrival = arrival;
+        job.service = 1;
+        dispatcher.route(job);
+    }
+    dispatcher.flush();
+    busy.close();
+    idle.close();
+
+    Channel<WindowSummary> windows;
+    ClassMetrics classes;
+    runCpu("1", window, idle, windows, classes);
+    int64_t closedUntil = 0;
+    WindowSummary summary;
+    while (windows.pop(summary)) {
+        closedUntil = summary.end;
+    }
+    return closedUntil >= lastArrival;
+}
+
+// ----------------------------------------
+// Fluid mode: estimates RR (processor sharing) or FB (least attained service) on workloads too
+// large for the slice-by-slice engines. The input is the --stream format; jobs with the same
+// arrival and service become one class. With --compare SPEC the workload is also run through
+// the exact streaming engine and the error of the approximation is reported; this keeps every
+// job in memory and is meant for small inputs.
+class FluidSummary : public FluidObserver {
+public:
+    uint64_t jobs = 0;
+    double turnaroundSum = 0;
+    double normalizedSum = 0;
+    LogHistogram turnarounds;
+    std::map<std::pair<int64_t, int64_t>, double>* finishTimes = nullptr;
+
+    void onFinish(const FluidClass& jobClass, double time) override {
+        double turnaround = time - double(jobClass.arrival);
+        jobs += jobClass.count;
+        turnaroundSum += turnaround * double(jobClass.count);
+        normalizedSum += turnaround / double(jobClass.service) * double(jobClass.count);
+        turnarounds.add(static_cast<uint64_t>(std::llround(turnaround)), jobClass.count);
+        if (finishTimes) {
+            (*finishTimes)[{jobClass.arrival, jobClass.service}] = time;
+        }
+    }
+};
+
+class ExactSummary : public OnlineObserver {
+public:
+    std::vector<int64_t> finish;  // by engine sequence number - 1
+    LogHistogram turnarounds;
+
+    void onFinish(const OnlineJob& job, int64_t time) override {
+        finish[job.seq - 1] = time;
+        turnarounds.add(static_cast<uint64_t>(time - job.arrival));
+    }
+};
+
+class JobListSource : public ArrivalSource {
+private:
+    const std::vector<OnlineJob>& jobs;
+    size_t nextIndex = 0;
+
+public:
+    explicit JobListSource(const std::vector<OnlineJob>& jobs) : jobs(jobs) {}
+
+    bool next(OnlineJob& job) override {
+        if (nextIndex == jobs.size()) {
+            return false;
+        }
+        job = jobs[nextIndex++];
+        return true;
+    }
+};
+
+// CSV of fluid mode: one schema for every row. `source` is fluid, exact or error; summary rows
+// leave the error columns empty and the error row leaves the summary columns empty.
+const char fluidCsvHeader[] =
+    "source,discipline,jobs,classes,end,mean_turnaround,mean_norm_turn,turnaround_p50,turnaround_p95,turnaround_p99,"
+    "mean_turnaround_pct,mean_norm_turn_pct,turnaround_p95_pct,finish_abs_mean,finish_abs_max\n";
+
+// The p-th percentile by rank, like LogHistogram::percentile but without bucketing.
+double exactPercentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0;
+    }
+    size_t rank = std::max<size_t>(1, static_cast<size_t>(std::ceil(p * values.size()))) - 1;
+    std::nth_element(values.begin(), values.begin() + rank, values.end());
+    return values[rank];
+}
+
+// The exact run of --compare is not aggregated, so it has no class count.
+void writeFluidSummary(const char* source, const std::string& label, const FluidSummary& summary,
+                       std::optional<size_t> classes, double end, OutputFormat format) {
+    double n = double(std::max<uint64_t>(1, summary.jobs));
+    double values[] = {summary.turnaroundSum / n, summary.normalizedSum / n, summary.turnarounds.percentile(0.5),
+                       summary.turnarounds.percentile(0.95), summary.turnarounds.percentile(0.99)};
+    unsigned long long jobs = summary.jobs;
+    char count[48] = "";
+    char line[320];
+    if (format == OutputFormat::Json) {
+        if (classes) snprintf(count, sizeof(count), "\"classes\":%zu,", *classes);
+        snprintf(line, sizeof(line),
+                 "{\"discipline\":\"%s\",\"jobs\":%llu,%s\"end\":%.3f,\"meanTurnaround\":%.3f,"
+                 "\"meanNormTurn\":%.3f,\"turnaroundP50\":%.1f,\"turnaroundP95\":%.1f,\"turnaroundP99\":%.1f}\n",
+                 label.c_str(), jobs, count, end, values[0], values[1], values[2], values[3], values[4]);
+    } else if (format == OutputFormat::Csv) {
+        if (classes) snprintf(count, sizeof(count), "%zu", *classes);
+        snprintf(line, sizeof(line), "%s,%s,%llu,%s,%.3f,%.3f,%.3f,%.1f,%.1f,%.1f,,,,,\n",
+                 source, label.c_str(), jobs, count, end, values[0], values[1], values[2], values[3], values[4]);
+    } else {
+        if (classes) snprintf(count, sizeof(count), "  classes %zu", *classes);
+        snprintf(line, sizeof(line),
+                 "%s  jobs %llu%s  end %.3f  turnaround mean %.3f p50 %.1f p95 %.1f p99 %.1f  normalized mean %.3f\n",
+                 label.c_str(), jobs, count, end, values[0], values[2], values[3], values[4], values[1]);
+    }
+    std::cout << line;
+}
+
+int runFluid(std::istream& in, const std::string& discipline, const std::string& compareSpec, OutputFormat format) {
+    FluidDiscipline kind;
+    std::string label;
+    if (discipline == "ps") {
+        kind = FluidDiscipline::ProcessorSharing;
+        label = "PS";
+    } else if (discipline == "las") {
+        kind = FluidDiscipline::LeastAttained;
+        label = "LAS";
+    } else {
+        std::cerr << "Error: Unknown fluid discipline " << discipline << ". Expected ps or las.\n";
+        return 1;
+    }
+    // The fluid limits approximate RR (PS) and FB (LAS); other policies have no fluid counterpart.
+    const bool compare = !compareSpec.empty();
+    const std::string compareId = compareSpec.substr(0, compareSpec.find('-'));
+    if (compare && (!(compareId == "2" || compareId == "6" || compareId == "7") || !OnlineScheduler(compareSpec).isValid())) {
+        std::cerr << "Error: --compare needs RR (2-q) or FB (6 or 7).\n";
+        return 1;
+    }
+
+    FluidSummary summary;
+    std::map<std::pair<int64_t, int64_t>, double> finishTimes;
+    if (compare) {
+        summary.finishTimes = &finishTimes;
+    }
+    FluidScheduler scheduler(kind, summary);
+
+    // Jobs of one arrival time are grouped by service before they enter the engine.
+    StreamArrivalSource source(in);
+    std::vector<OnlineJob> jobs;
+    std::map<int64_t, uint64_t> group;
+    int64_t groupArrival = 0;
+    auto flush = [&]() {
+        for (const auto& [service, count] : group) {
+            scheduler.arrive(FluidClass{groupArrival, service, count});
+        }
+        group.clear();
+    };
+    OnlineJob job;
+    while (source.next(job)) {
+        if (job.arrival != groupArrival) {
+            flush();
+            groupArrival = job.arrival;
+        }
+        ++group[job.service];
+        if (compare) {
+            jobs.push_back(job);
+        }
+    }
+    flush();
+    double end = scheduler.drain();
+    if (format == OutputFormat::Csv) {
+        std::cout << fluidCsvHeader;
+    }
+    writeFluidSummary("fluid", label, summary, scheduler.classes(), end, format);
+    if (!compare) {
+        return 0;
+    }
+
+    std::string name;
+    createPolicy(compareSpec, name);
+    OnlineScheduler exact(compareSpec);
+    ExactSummary exactSummary;
+    exactSummary.finish.resize(jobs.size());
+    JobListSource exactSource(jobs);
+    exact.run(exactSource, exactSummary);
+
+    FluidSummary exactTotals;
+    double absSum = 0, absMax = 0;
+    int64_t exactEnd = 0;
+    // Every job is in memory here, so the p95 error uses exact order statistics rather than the
+    // histograms, whose buckets are about 3% wide.
+    std::vector<double> fluidTurnarounds, exactTurnarounds;
+    fluidTurnarounds.reserve(jobs.size());
+    exactTurnarounds.reserve(jobs.size());
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        FluidClass one{jobs[i].arrival, jobs[i].service, 1};
+        exactTotals.onFinish(one, double(exactSummary.finish[i]));
+        exactEnd = std::max(exactEnd, exactSummary.finish[i]);
+        double fluidFinish = finishTimes[{jobs[i].arrival, jobs[i].service}];
+        fluidTurnarounds.push_back(fluidFinish - double(jobs[i].arrival));
+        exactTurnarounds.push_back(double(exactSummary.finish[i] - jobs[i].arrival));
+        double error = std::fabs(fluidFinish - double(exactSummary.finish[i]));
+        absSum += error;
+        absMax = std::max(absMax, error);
+    }
+    writeFluidSummary("exact", name, exactTotals, std::nullopt, double(exactEnd), format);
+
+    auto relative = [](double approx, double reference) {
+        return reference == 0 ? 0.0 : 100.0 * (approx - reference) / reference;
+    };
+    double n = double(std::max<size_t>(1, jobs.size()));
+    double errors[] = {relative(summary.turnaroundSum, exactTotals.turnaroundSum),
+                       relative(summary.normalizedSum, exactTotals.normalizedSum),
+                       relative(exactPercentile(std::move(fluidTurnarounds), 0.95),
+                                exactPercentile(std::move(exactTurnarounds), 0.95)),
+                       absSum / n, absMax};
+    char line[256];
+    if (format == OutputFormat::Json) {
+        snprintf(line, sizeof(line),
+                 "{\"error\":\"%s vs %s\",\"meanTurnaroundPct\":%.2f,\"meanNormTurnPct\":%.2f,\"turnaroundP95Pct\":%.2f,"
+                 "\"finishAbsMean\":%.3f,\"finishAbsMax\":%.3f}\n",
+                 label.c_str(), name.c_str(), errors[0], errors[1], errors[2], errors[3], errors[4]);
+    } else if (format == OutputFormat::Csv) {
+        snprintf(line, sizeof(line), "error,%s vs %s,,,,,,,,,%.2f,%.2f,%.2f,%.3f,%.3f\n",
+                 label.c_str(), name.c_str(), errors[0], errors[1], errors[2], errors[3], errors[4]);
+    } else {
+        snprintf(line, sizeof(line),
+                 "error %s vs %s  turnaround mean %+.2f%%  p95 %+.2f%%  normalized mean %+.2f%%  finish |error| mean %.3f max %.3f\n",
+                 label.c_str(), name.c_str(), errors[0], errors[2], errors[1], errors[3], errors[4]);
+    }
+    std::cout << line;
+    return 0;
+}
+
+// ----------------------------------------
+// Importer for Linux scheduler traces: the text output of `perf script` or `trace-cmd report`
+// (or a raw ftrace buffer) with sched_switch and sched_wakeup events. Both the key=value and the
+// compact "comm:pid [prio] state ==> comm:pid [prio]" payloads are understood. The file is
+// memory-mapped and split at line boundaries into one chunk per thread; events keep pointers
+// into the mapping, so task names are never copied while parsing.
+struct SchedEvent {
+    enum Type : uint8_t { Switch, Wakeup };
+    double time;
+    Type type;
+    bool prevRunnable;
+    int prevPid;
+    int pid;  // next_pid for Switch, the woken task for Wakeup
+    std::string_view prevComm;
+    std::string_view comm;
+};
+
+struct ImportedJob {
+    double arrival;
+    double service;
+    int pid;
+    std::string_view comm;
+};
+
+std::string_view trimView(std::string_view text) {
+    size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+    return text.substr(begin, text.find_last_not_of(" \t\r") - begin + 1);
+}
+
+bool parseIntView(std::string_view text, int& value) {
+    text = trimView(text);
+    return !text.empty() && std::from_chars(text.data(), text.data() + text.size(), value).ec == std::errc();
+}
+
+// Value of "key=" up to the next " word=" (or the end), allowing spaces inside comm names.
+std::string_view keyValue(std::string_view payload, std::string_view key) {
+    size_t at = 0;
+    while ((at = payload.find(key, at)) != std::string_view::npos) {
+        if (at == 0 || payload[at - 1] == ' ') break;
+        at += key.size();
+    }
+    if (at == std::string_view::npos) {
+        return {};
+    }
+    size_t begin = at + key.size();
+    size_t end = begin;
+    while (end < payload.size()) {
+        size_t space = payload.find(' ', end);
+        if (space == std::string_view::npos) {
+            end = payload.size();
+            break;
+        }
+        size_t word = space + 1;
+        while (word < payload.size() && payload[word] != ' ' && payload[word] != '=') ++word;
+        if (word < payload.size() && payload[word] == '=') {
+            end = space;
+            break;
+        }
+        end = space + 1;
+    }
+    return trimView(payload.substr(begin, end - begin));
+}
+
+// "comm:pid [prio]" in the compact payloads; comm may itself contain ':' (kworker/1:1).
+bool parseCommPid(std::string_view text, std::string_view& comm, int& pid) {
+    text = trimView(text);
+    size_t bracket = text.rfind(" [");
+    if (bracket != std::string_view::npos) {
+        text = trimView(text.substr(0, bracket));
+    }
+    size_t colon = text.rfind(':');
+    if (colon == std::string_view::npos) {
+        return false;
+    }
+    comm = text.substr(0, colon);
+    return parseIntView(text.substr(colon + 1), pid);
+}
+
+bool isRunnableState(std::string_view state) {
+    state = trimView(state);
+    return !state.empty() && state[0] == 'R';
+}
+
+bool parseSchedLine(std::string_view line, SchedEvent& event) {
+    size_t at = line.find("sched_switch:");
+    size_t nameLength = 13;
+    event.type = SchedEvent::Switch;
+    if (at == std::string_view::npos) {
+        at = line.find("sched_wakeup");
+        if (at == std::string_view::npos) {
+            return false;
+        }
+        size_t colon = line.find(':', at);
+        if (colon == std::string_view::npos) {
+            return false;
+        }
+        nameLength = colon + 1 - at;
+        event.type = SchedEvent::Wakeup;
+    }
+
+    // The timestamp is the "<seconds>:" token in front of the (possibly "sched:"-prefixed) event.
+    size_t head = at;
+    if (head >= 6 && line.substr(head - 6, 6) == "sched:") head -= 6;
+    size_t stampEnd = line.find_last_not_of(' ', head == 0 ? 0 : head - 1);
+    if (stampEnd == std::string_view::npos || line[stampEnd] != ':') {
+        return false;
+    }
+    size_t stampBegin = line.find_last_of(' ', stampEnd);
+    stampBegin = stampBegin == std::string_view::npos ? 0 : stampBegin + 1;
+    std::string stamp(line.substr(stampBegin, stampEnd - stampBegin));
+    char* end = nullptr;
+    event.time = std::strtod(stamp.c_str(), &end);
+    if (end == stamp.c_str()) {
+        return false;
+    }
+
+    std::string_view payload = trimView(line.substr(at + nameLength));
+    if (event.type == SchedEvent::Switch) {
+        size_t arrow = payload.find("==>");
+        if (arrow == std::string_view::npos) {
+            return false;
+        }
+        if (payload.find("prev_pid=") != std::string_view::npos) {
+            event.prevComm = keyValue(payload, "prev_comm=");
+            event.comm = keyValue(payload.substr(arrow + 3), "next_comm=");
+            event.prevRunnable = isRunnableState(keyValue(payload.substr(0, arrow), "prev_state="));
+            return parseIntView(keyValue(payload, "prev_pid="), event.prevPid) &&
+                   parseIntView(keyValue(payload.substr(arrow + 3), "next_pid="), event.pid);
+        }
+        std::string_view prev = trimView(payload.substr(0, arrow));
+        size_t stateAt = prev.rfind(' ');
+        if (stateAt == std::string_view::npos) {
+            return false;
+        }
+        event.prevRunnable = isRunnableState(prev.substr(stateAt + 1));
+        return parseCommPid(prev.substr(0, stateAt), event.prevComm, event.prevPid) &&
+               parseCommPid(payload.substr(arrow + 3), event.comm, event.pid);
+    }
+
+    event.prevPid = 0;
+    event.prevRunnable = false;
+    if (payload.find("pid=") != std::string_view::npos) {
+        event.comm = keyValue(payload, "comm=");
+        return parseIntView(keyValue(payload, "pid="), event.pid);
+    }
+    size_t bracket = payload.find(" [");
+    return parseCommPid(payload.substr(0, bracket == std::string_view::npos ? payload.size() : bracket), event.comm, event.pid);
+}
+
+// Turns the event sequence into jobs: a job starts when a task is woken (or first switched in)
+// and ends when it is switched out in a blocking state; preemptions inside it only pause the
+// burst. Its service is the CPU time the task received in between. pid 0 (idle) is ignored.
+std::vector<ImportedJob> deriveJobs(const std::vector<SchedEvent>& events) {
+    struct TaskState {
+        bool open = false;
+        double arrival = 0;
+        double runningSince = -1;
+        double service = 0;
+        std::string_view comm;
+    };
+    std::unordered_map<int, TaskState> tasks;
+    std::vector<ImportedJob> jobs;
+
+    auto close = [&](int pid, TaskState& task) {
+        if (task.service > 0) {
+            jobs.push_back(ImportedJob{task.arrival, task.service, pid, task.comm});
+        }
+        task.open = false;
+        task.service = 0;
+    };
+
+    for (const auto& event : events) {
+        if (event.type == SchedEvent::Wakeup) {
+            if (event.pid == 0) continue;
+            TaskState& task = tasks[event.pid];
+            if (!task.open) {
+                task.open = true;
+                task.arrival = event.time;
+                task.comm = event.comm;
+            }
+            continue;
+        }
+
+        if (event.prevPid != 0) {
+            TaskState& prev = tasks[event.prevPid];
+            if (prev.runningSince >= 0) {
+                prev.service += event.time - prev.runningSince;
+                prev.runningSince = -1;
+            }
+            if (prev.comm.empty()) prev.comm = event.prevComm;
+            if (!event.prevRunnable && prev.open) {
+                close(event.prevPid, prev);
+            }
+        }
+        if (event.pid != 0) {
+            TaskState& next = tasks[event.pid];
+            if (!next.open) {
+                next.open = true;
+                next.arrival = event.time;
+            }
+            if (next.comm.empty()) next.comm = event.comm;
+            next.runningSince = event.time;
+        }
+    }
+
+    double last = events.empty() ? 0 : events.back().time;
+    for (auto& entry : tasks) {
+        TaskState& task = entry.second;
+        if (task.runningSince >= 0) {
+            task.service += last - task.runningSince;
+        }
+        if (task.open) close(entry.first, task);
+    }
+
+    std::stable_sort(jobs.begin(), jobs.end(), [](const ImportedJob& a, const ImportedJob& b) {
+        return a.arrival < b.arrival || (a.arrival == b.arrival && a.pid < b.pid);
+    });
+    return jobs;
+}
+
+// emit is "stream" (name,arrival,service lines for --stream) or "scenario" (a stats scenario for
+// the given policies; the first 52 jobs, renamed A-Z a-z). Times are converted to ticks of tickUs.
+int runImport(const std::string& path, double tickUs, const std::string& emit, const std::string& policies, unsigned jobs) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        std::cerr << "Error: Cannot read trace " << path << ".\n";
+        if (fd >= 0) ::close(fd);
+        return 1;
+    }
+    size_t size = info.st_size;
+    const char* data = "";
+    void* mapped = MAP_FAILED;
+    if (size > 0) {
+        mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            std::cerr << "Error: Cannot map trace " << path << ".\n";
+            ::close(fd);
+            return 1;
+        }
+        data = static_cast<const char*>(mapped);
+        madvise(mapped, size, MADV_SEQUENTIAL);
+    }
+    ::close(fd);
+
+    // Chunk boundaries are moved forward to the next newline so every line lands in one chunk.
+    size_t chunks = std::max<size_t>(1, std::min<size_t>(jobs, size / (1 << 20) + 1));
+    std::vector<size_t> bounds(chunks + 1, size);
+    bounds[0] = 0;
+    for (size_t c = 1; c < chunks; ++c) {
+        size_t at = std::max(bounds[c - 1], size / chunks * c);
+        const void* newline = at < size ? std::memchr(data + at, '\n', size - at) : nullptr;
+        bounds[c] = newline ? static_cast<const char*>(newline) - data + 1 : size;
+    }
+
+    std::vector<std::vector<SchedEvent>> parsed(chunks);
+    auto parseChunk = [&](size_t c) {
+        std::string_view text(data + bounds[c], bounds[c + 1] - bounds[c]);
+        SchedEvent event;
+        while (!text.empty()) {
+            size_t newline = text.find('\n');
+            std::string_view line = text.substr(0, newline);
+            if (parseSchedLine(line, event)) {
+                parsed[c].push_back(event);
+            }
+            text.remove_prefix(newline == std::string_view::npos ? text.size() : newline + 1);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t c = 1; c < chunks; ++c) {
+        workers.emplace_back(parseChunk, c);
+    }
+    parseChunk(0);
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    std::vector<SchedEvent> events;
+    size_t total = 0;
+    for (const auto& chunk : parsed) total += chunk.size();
+    events.reserve(total);
+    for (auto& chunk : parsed) {
+        events.insert(events.end(), chunk.begin(), chunk.end());
+        std::vector<SchedEvent>().swap(chunk);
+    }
+    auto byTime = [](const SchedEvent& a, const SchedEvent& b) { return a.time < b.time; };
+    if (!std::is_sorted(events.begin(), events.end(), byTime)) {
+        std::stable_sort(events.begin(), events.end(), byTime);
+    }
+
+    std::vector<ImportedJob> imported = deriveJobs(events);
+    double origin = imported.empty() ? 0 : imported.front().arrival;
+    auto toTicks = [&](double seconds) { return std::llround(seconds * 1e6 / tickUs); };
+
+    std::string out;
+    char digits[24];
+    auto appendInt = [&](long long value) {
+        out.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr);
+    };
+
+    if (emit == "scenario") {
+        size_t count = std::min<size_t>(imported.size(), 52);
+        long long simulationEnd = 0;
+        for (size_t i = 0; i < count; ++i) {
+            simulationEnd = std::max(simulationEnd, toTicks(imported[i].arrival - origin)) +
+                            std::max(1LL, toTicks(imported[i].service));
+        }
+        out += "stats\n" + policies + "\n";
+        appendInt(simulationEnd);
+        out += '\n';
+        appendInt(count);
+        out += '\n';
+        for (size_t i = 0; i < count; ++i) {
+            out += static_cast<char>(i < 26 ? 'A' + i : 'a' + (i - 26));
+            out += ',';
+            appendInt(toTicks(imported[i].arrival - origin));
+            out += ',';
+            appendInt(std::max(1LL, toTicks(imported[i].service)));
+            out += '\n';
+        }
+        if (imported.size() > count) {
+            std::cerr << "Warning: scenario output keeps the first 52 of " << imported.size() << " jobs.\n";
+        }
+    } else {
+        for (const auto& job : imported) {
+            // The stream format has no quoting: a ',' or control character in the comm would split
+            // the line and a leading '#' would make it a comment, so those become '_'.
+            for (size_t i = 0; i < job.comm.size(); ++i) {
+                char c = job.comm[i];
+                bool unsafe = c == ',' || static_cast<unsigned char>(c) < 0x20 || c == 0x7f || (i == 0 && c == '#');
+                out += unsafe ? '_' : c;
+            }
+            out += '-';
+            appendInt(job.pid);
+            out += ',';
+            appendInt(toTicks(job.arrival - origin));
+            out += ',';
+            appendInt(std::max(1LL, toTicks(job.service)));
+            out += '\n';
+            if (out.size() >= (1 << 16)) {
+                std::cout.write(out.data(), out.size());
+                out.clear();
+            }
+        }
+    }
+    std::cout.write(out.data(), out.size());
+    std::cout.flush();
+
+    std::cerr << "Imported " << events.size() << " sched events into " << imported.size() << " jobs ("
+              << chunks << " parser chunks).\n";
+    if (mapped != MAP_FAILED) {
+        munmap(mapped, size);
+    }
+    return 0;
+}
+
+// Parses a whole command-line value; false (with a usage error) if it is not a number.
+template <typename T>
+bool parseArgument(const std::string& option, const char* text, T& value) {
+    const char* end = text + strlen(text);
+    auto parsed = std::from_chars(text, end, value);
+    if (parsed.ec != std::errc() || parsed.ptr != end || parsed.ptr == text) {
+        std::cerr << "Error: " << option << " expects a number, not \"" << text << "\".\n";
+        return false;
+    }
+    return true;
+}
+
+// Options read by some modes only, with the commands that read them ("" is a single scenario).
+struct ModeOption {
+    const char* name;
+    std::vector<const char*> modes;
+};
+
+const ModeOption modeOptions[] = {
+    {"--window", {"--stream"}},
+    {"--cpus", {"--stream"}},
+    {"--dispatch", {"--stream"}},
+    {"--compare", {"--fluid"}},
+    {"--emit", {"--import"}},
+    {"--policies", {"--import"}},
+    {"--tick-us", {"--import", "", "--stream"}},
+    {"--chrome-trace", {"", "--stream"}},
+    {"--trace-out", {""}},
+    {"--policy", {"--query"}},
+    {"--processes", {"--query"}},
+    {"--cache-dir", {"", "--batch"}},
+    {"--no-cache", {"", "--batch"}},
+    {"--dvfs", {"", "--batch"}},
+    {"--jobs", {"--batch", "--montecarlo", "--stream", "--import"}},
+    {"--seed", {"--verify", "--record-golden"}},
+    {"--cases", {"--verify", "--record-golden"}},
+};
+
+int main(int argc, char* argv[]) {
+    OutputFormat format = OutputFormat::Text;
+    std::string command, goldenPath, inputPath, traceOutPath, policyFilter, processFilter;
+    int windowStart = 0, windowEnd = 0;
+    std::string streamPolicy;
+    int64_t streamWindow = 100;
+    int cpus = 0;
+    std::string fluidDiscipline, compareSpec;
+    DispatchRule dispatchRule = DispatchRule::LeastWork;
+    double tickUs = 1000;
+    std::string emit = "stream", importPolicies = "1,2-4,3,4,5,6,7";
+    unsigned seed = 1;
+    int cases = 200;
+    unsigned jobs = std::max(1u, std::thread::hardware_concurrency());
+    std::string cacheDir;
+    std::string chromeTracePath;
+    SpeedModel speedModel;
+    bool scaled = false;
+    bool useCache = true;
+    std::vector<std::string> given;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        given.push_back(arg);
+        if (arg == "--montecarlo") {
+            command = arg;
+            if (i + 1 < argc && std::string(argv[i + 1]).compare(0, 2, "--") != 0) {
+                inputPath = argv[++i];
+            }
+        } else if (arg == "--batch") {
+            command = arg;
+            if (i + 1 < argc && std::string(argv[i + 1]).compare(0, 2, "--") != 0) {
+                inputPath = argv[++i];
+            }
+        } else if (arg == "--stream" && i + 1 < argc) {
+            command = arg;
+            streamPolicy = argv[++i];
+        } else if (arg == "--window" && i + 1 < argc) {
+            if (!parseArgument(arg, argv[++i], streamWindow)) return 1;
+        } else if (arg == "--fluid" && i + 1 < argc) {
+            command = arg;
+            fluidDiscipline = argv[++i];
+        } else if (arg == "--compare" && i + 1 < argc) {
+            compareSpec = argv[++i];
+        } else if (arg == "--cpus" && i + 1 < argc) {
+            if (!parseArgument(arg, argv[++i], cpus)) return 1;
+        } else if (arg == "--dispatch" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (value == "rr") {
+                dispatchRule = DispatchRule::RoundRobin;
+            } else if (value == "lwl") {
+                dispatchRule = DispatchRule::LeastWork;
+            } else {
+                std::cerr << "Error: Unknown dispatch rule " << value << ". Expected rr or lwl.\n";
+                return 1;
+            }
+        } else if (arg == "--import" && i + 1 < argc) {
+            command = arg;
+            inputPath = argv[++i];
+        } else if (arg == "--tick-us" && i + 1 < argc) {
+            if (!parseArgument(arg, argv[++i], tickUs)) return 1;
+        } else if (arg == "--emit" && i + 1 < argc) {
+            emit = argv[++i];
+        } else if (arg == "--policies" && i + 1 < argc) {
+            importPolicies = argv[++i];
+        } else if (arg == "--chrome-trace" && i + 1 < argc) {
+            chromeTracePath = argv[++i];
+        } else if (arg == "--trace-out" && i + 1 < argc) {
+            traceOutPath = argv[++i];
+        } else if (arg == "--query" && i + 3 < argc) {
+            command = arg;
+            inputPath = argv[++i];
+            if (!parseArgument(arg, argv[++i], windowStart) || !parseArgument(arg, argv[++i], windowEnd)) return 1;
+        } else if (arg == "--policy" && i + 1 < argc) {
+            policyFilter = argv[++i];
+        } else if (arg == "--processes" && i + 1 < argc) {
+            processFilter = argv[++i];
+        } else if (arg == "--cache-dir" && i + 1 < argc) {
+            cacheDir = argv[++i];
+        } else if (arg == "--dvfs" && i + 1 < argc) {
+            scaled = true;
+            if (!speedModel.parse(argv[++i])) {
+                std::cerr << "Error: Unknown speed model " << argv[i] << ". Expected GOVERNOR[:F1,F2,...][@CAPACITY].\n";
+                return 1;
+            }
+        } else if (arg == "--no-cache") {
+            useCache = false;
+        } else if (arg == "--jobs" && i + 1 < argc) {
+            int value;
+            if (!parseArgument(arg, argv[++i], value)) return 1;
+            jobs = std::max(1, value);
+        } else if (arg == "--verify") {
+            command = arg;
+        } else if ((arg == "--golden" || arg == "--record-golden") && i + 1 < argc) {
+            command = arg;
+            goldenPath = argv[++i];
+        } else if (arg == "--seed" && i + 1 < argc) {
+            if (!parseArgument(arg, argv[++i], seed)) return 1;
+        } else if (arg == "--cases" && i + 1 < argc) {
+            if (!parseArgument(arg, argv[++i], cases)) return 1;
+        } else if (arg == "--format" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (value == "json") {
+                format = OutputFormat::Json;
+            } else if (value == "csv") {
+                format = OutputFormat::Csv;
+            } else if (value != "text") {
+                std::cerr << "Error: Unknown output format " << value << ".\n";
+                return 1;
+            }
+        } else {
+            std::cerr << "Error: Unknown argument " << arg << ".\n";
+            return 1;
+        }
+    }
+
+    // Options that only some modes read are errors elsewhere rather than silently ignored.
+    for (const auto& arg : given) {
+        for (const auto& option : modeOptions) {
+            if (arg != option.name) {
+                continue;
+            }
+            bool applies = false;
+            for (const char* mode : option.modes) {
+                applies = applies || command == mode;
+            }
+            if (!applies) {
+                std::cerr << "Error: " << arg << " does not apply to "
+                          << (command.empty() ? std::string("a single scenario") : command) << ".\n";
+                return 1;
+            }
+        }
+    }
+
+    if (command == "--verify") {
+        return runVerify(seed, cases);
+    } else if (command == "--golden") {
+        return checkGolden(goldenPath);
+    } else if (command == "--record-golden") {
+        return recordGolden(goldenPath, seed, cases);
+    } else if (command == "--query") {
+        return queryTraceFile(inputPath, windowStart, windowEnd, policyFilter, processFilter);
+    }
+
+    if (command == "--import") {
+        if (tickUs <= 0 || (emit != "stream" && emit != "scenario")) {
+            std::cerr << "Error: --import needs a positive --tick-us and --emit stream|scenario.\n";
+            return 1;
+        }
+        return runImport(inputPath, tickUs, emit, importPolicies, jobs);
+    }
+
+    if (!chromeTracePath.empty() && command == "--stream" && cpus != 0) {
+        std::cerr << "Error: --chrome-trace covers single-CPU streams only.\n";
+        return 1;
+    }
+    ChromeTraceWriter chromeTrace;
+    if (!chromeTracePath.empty() && !chromeTrace.open(chromeTracePath, tickUs)) {
+        std::cerr << "Error: Cannot write Chrome trace " << chromeTracePath << ".\n";
+        return 1;
+    }
+
+    if (command == "--stream") {
+        std::ios::sync_with_stdio(false);
+        if (cpus != 0) {
+            return runMultiCpuStream(std::cin, std::cout, streamPolicy, cpus, dispatchRule, streamWindow, format, jobs);
+        }
+        return runStream(std::cin, streamPolicy, streamWindow, format, chromeTrace.isOpen() ? &chromeTrace : nullptr);
+    }
+
+    if (command == "--fluid") {
+        std::ios::sync_with_stdio(false);
+        return runFluid(std::cin, fluidDiscipline, compareSpec, format);
+    }
+
+    if (command == "--montecarlo") {
+        if (inputPath.empty() || inputPath == "-") {
+            return runMonteCarlo(std::cin, jobs, format);
+        }
+        std::ifstream file(inputPath);
+        if (!file) {
+            std::cerr << "Error: Cannot read Monte Carlo spec " << inputPath << ".\n";
+            return 1;
+        }
+        return runMonteCarlo(file, jobs, format);
+    }
+
+    ResultCache cache(cacheDir);
+    if (command == "--batch") {
+        std::ios::sync_with_stdio(false);
+        if (inputPath.empty() || inputPath == "-") {
+            return runBatch(std::cin, format, jobs, useCache ? &cache : nullptr, scaled ? &speedModel : nullptr);
+        }
+        std::ifstream file(inputPath);
+        if (!file) {
+            std::cerr << "Error: Cannot read batch file " << inputPath << ".\n";
+            return 1;
+        }
+        return runBatch(file, format, jobs, useCache ? &cache : nullptr, scaled ? &speedModel : nullptr);
+    }
+
+    // A single scenario rarely repeats a run, so it only caches when results can outlive it.
+    ResultWriter writer(format, std::cout, std::cerr);
+    if (useCache && !cacheDir.empty()) {
+        writer.setCache(&cache);
+    }
+    if (scaled) {
+        writer.setSpeedModel(&speedModel);
+    }
+    if (chromeTrace.isOpen()) {
+        writer.setChromeTrace(&chromeTrace);
+    }
+    TraceFileWriter traceFile;
+    if (!traceOutPath.empty()) {
+        if (!traceFile.open(traceOutPath)) {
+            std::cerr << "Error: Cannot write trace file " << traceOutPath << ".\n";
+            return 1;
+        }
+        writer.setTraceFile(&traceFile);
+    }
+    int status = runScenario(std::cin, writer);
+    writer.end();
+    return status;
+}
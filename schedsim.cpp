@@ -0,0 +1,282 @@
+// schedsim: the simulation library as a CPython extension module, so the GUI can run policies
+// in-process instead of spawning lab6 and parsing its output.
+//
+//   import schedsim
+//   run = schedsim.simulate("2-4", 20, [("A", 0, 3), ("B", 2, 6)])
+//   run = schedsim.simulate("10-2", 20, [("A", 0, 3, 1), ("B", 2, 6, 3)])   # priority policies
+//   run["finish"]             # int32 array, one entry per process (0 = unfinished)
+//   run["timeline"]           # uint8 array of shape (processes, simulationEnd): IDLE/READY/RUNNING
+//   memoryview(run["finish"]).tolist(), numpy.asarray(run["timeline"])
+//
+// Results are cached by content (see ResultCache), so repeating a run does not simulate again.
+//
+// Arrays are schedsim.Array objects that own their storage and export it through the buffer
+// protocol, so memoryview and numpy.asarray read it without copying.
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "scheduler.h"
+
+namespace {
+
+enum CellState : uint8_t { Idle = 0, Ready = 1, Running = 2 };
+
+// Repeated runs (the GUI's retry flow) are answered from here; set_cache_dir adds a disk store.
+std::shared_ptr<ResultCache> cache = std::make_shared<ResultCache>();
+
+struct ArrayObject {
+    PyObject_HEAD
+    std::vector<char>* data;
+    const char* format;
+    Py_ssize_t itemSize;
+    int ndim;
+    Py_ssize_t shape[2];
+    Py_ssize_t strides[2];
+};
+
+void arrayDealloc(PyObject* self) {
+    delete reinterpret_cast<ArrayObject*>(self)->data;
+    Py_TYPE(self)->tp_free(self);
+}
+
+int arrayGetBuffer(PyObject* self, Py_buffer* view, int flags) {
+    ArrayObject* array = reinterpret_cast<ArrayObject*>(self);
+    if (flags & PyBUF_WRITABLE) {
+        PyErr_SetString(PyExc_BufferError, "schedsim arrays are read-only");
+        view->obj = nullptr;
+        return -1;
+    }
+    view->obj = self;
+    Py_INCREF(self);
+    view->buf = array->data->data();
+    view->len = static_cast<Py_ssize_t>(array->data->size());
+    view->readonly = 1;
+    view->itemsize = array->itemSize;
+    view->format = (flags & PyBUF_FORMAT) ? const_cast<char*>(array->format) : nullptr;
+    view->ndim = array->ndim;
+    view->shape = (flags & PyBUF_ND) == PyBUF_ND ? array->shape : nullptr;
+    view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? array->strides : nullptr;
+    view->suboffsets = nullptr;
+    view->internal = nullptr;
+    return 0;
+}
+
+Py_ssize_t arrayLength(PyObject* self) {
+    return reinterpret_cast<ArrayObject*>(self)->shape[0];
+}
+
+PyBufferProcs arrayBufferProcs = {arrayGetBuffer, nullptr};
+PySequenceMethods arraySequenceMethods = {arrayLength};
+
+PyTypeObject ArrayType = {PyVarObject_HEAD_INIT(nullptr, 0) "schedsim.Array"};
+
+// Takes ownership of data; without rows and cols it is a one-dimensional array of
+// data.size() / itemSize items. A (rows, cols) array stays two-dimensional when either is 0.
+PyObject* newArray(std::vector<char>* data, const char* format, Py_ssize_t itemSize, Py_ssize_t rows = -1, Py_ssize_t cols = 0) {
+    ArrayObject* array = PyObject_New(ArrayObject, &ArrayType);
+    if (!array) {
+        delete data;
+        return nullptr;
+    }
+    array->data = data;
+    array->format = format;
+    array->itemSize = itemSize;
+    if (rows < 0) {
+        array->ndim = 1;
+        array->shape[0] = static_cast<Py_ssize_t>(data->size()) / itemSize;
+        array->strides[0] = itemSize;
+    } else {
+        array->ndim = 2;
+        array->shape[0] = rows;
+        array->shape[1] = cols;
+        array->strides[0] = cols * itemSize;
+        array->strides[1] = itemSize;
+    }
+    return reinterpret_cast<PyObject*>(array);
+}
+
+PyObject* newIntArray(const std::vector<int32_t>& values, Py_ssize_t rows = -1, Py_ssize_t cols = 0) {
+    auto* data = new std::vector<char>(values.size() * sizeof(int32_t));
+    if (!values.empty()) {
+        std::memcpy(data->data(), values.data(), data->size());
+    }
+    return newArray(data, "i", sizeof(int32_t), rows, cols);
+}
+
+// Sets key to value in dict and drops the reference to value; false (with an exception) on failure.
+bool setItem(PyObject* dict, const char* key, PyObject* value) {
+    if (!value) {
+        return false;
+    }
+    int status = PyDict_SetItemString(dict, key, value);
+    Py_DECREF(value);
+    return status == 0;
+}
+
+PyObject* resultToDict(const SimulationResult& result, bool prioritized) {
+    const size_t n = result.processes.size();
+    std::string names;
+    std::vector<int32_t> arrival(n), third(n), finish(n), priority(n);
+    for (size_t i = 0; i < n; ++i) {
+        const Process& process = result.processes[i];
+        names += process.name;
+        arrival[i] = process.arrivalTime;
+        third[i] = result.hasStats ? process.serviceTime : process.initialPriority;
+        finish[i] = process.finishTime;
+        priority[i] = process.initialPriority;
+    }
+
+    auto* cells = new std::vector<char>(n * result.simulationEnd, Idle);
+    for (size_t i = 0; i < n; ++i) {
+        const std::vector<char>& row = result.timeline[i];
+        char* out = cells->data() + i * result.simulationEnd;
+        for (int t = 0; t < result.simulationEnd; ++t) {
+            out[t] = row[t] == '*' ? Running : row[t] == '.' ? Ready : Idle;
+        }
+    }
+
+    std::vector<int32_t> trajectory;
+    for (const auto& change : result.quantumTrajectory) {
+        trajectory.push_back(change.time);
+        trajectory.push_back(change.quantum);
+    }
+
+    PyObject* dict = PyDict_New();
+    if (!dict) {
+        delete cells;
+        return nullptr;
+    }
+    bool ok = setItem(dict, "policy", PyUnicode_FromStringAndSize(result.policy.data(), result.policy.size())) &&
+              setItem(dict, "simulationEnd", PyLong_FromLong(result.simulationEnd)) &&
+              setItem(dict, "names", PyUnicode_FromStringAndSize(names.data(), names.size())) &&
+              setItem(dict, "arrival", newIntArray(arrival)) &&
+              setItem(dict, result.hasStats ? "service" : "priority", newIntArray(third)) &&
+              setItem(dict, "finish", newIntArray(finish)) &&
+              setItem(dict, "timeline", newArray(cells, "B", 1, static_cast<Py_ssize_t>(n), result.simulationEnd)) &&
+              setItem(dict, "quantumTrajectory", newIntArray(trajectory, static_cast<Py_ssize_t>(trajectory.size() / 2), 2)) &&
+              (!prioritized || setItem(dict, "priority", newIntArray(priority)));
+    if (!ok) {
+        Py_DECREF(dict);
+        return nullptr;
+    }
+    return dict;
+}
+
+PyObject* simulateMethod(PyObject*, PyObject* args) {
+    const char* policy;
+    int simulationEnd;
+    PyObject* processList;
+    if (!PyArg_ParseTuple(args, "siO:simulate", &policy, &simulationEnd, &processList)) {
+        return nullptr;
+    }
+    if (simulationEnd < 0) {
+        PyErr_SetString(PyExc_ValueError, "simulation end must not be negative");
+        return nullptr;
+    }
+    bool aging = policy[0] == '8';
+
+    PyObject* sequence = PySequence_Fast(processList, "processes must be a sequence of (name, arrival, service[, priority]) tuples");
+    if (!sequence) {
+        return nullptr;
+    }
+    std::vector<Process> processes;
+    Py_ssize_t count = PySequence_Fast_GET_SIZE(sequence);
+    for (Py_ssize_t i = 0; i < count; ++i) {
+        const char* name;
+        Py_ssize_t nameLength;
+        int arrival, third, priority = 0;
+        if (!PyArg_ParseTuple(PySequence_Fast_GET_ITEM(sequence, i), "s#ii|i", &name, &nameLength, &arrival, &third, &priority)) {
+            Py_DECREF(sequence);
+            return nullptr;
+        }
+        if (nameLength != 1 || arrival < 0 || (!aging && third < 1)) {
+            Py_DECREF(sequence);
+            PyErr_Format(PyExc_ValueError, "process %zd: expected a one-character name, arrival >= 0 and service >= 1", i + 1);
+            return nullptr;
+        }
+        if (!isValidPriority(priority)) {
+            Py_DECREF(sequence);
+            PyErr_Format(PyExc_ValueError, "process %zd: priority must be 0-%d", i + 1, priorityLevels - 1);
+            return nullptr;
+        }
+        Process process;
+        process.name = name[0];
+        process.arrivalTime = arrival;
+        if (aging) {
+            process.initialPriority = process.priority = third;
+        } else {
+            process.serviceTime = third;
+            process.initialPriority = process.priority = priority;
+        }
+        processes.push_back(process);
+    }
+    Py_DECREF(sequence);
+
+    SimulationResult result;
+    std::shared_ptr<ResultCache> runCache = cache;
+    bool known;
+    Py_BEGIN_ALLOW_THREADS
+    known = runCache->simulate(processes, policy, simulationEnd, result);
+    Py_END_ALLOW_THREADS
+    if (!known) {
+        PyErr_Format(PyExc_ValueError, "unknown policy %s", policy);
+        return nullptr;
+    }
+    return resultToDict(result, isPriorityPolicy(policy));
+}
+
+PyObject* setCacheDirMethod(PyObject*, PyObject* args) {
+    const char* directory;
+    if (!PyArg_ParseTuple(args, "s:set_cache_dir", &directory)) {
+        return nullptr;
+    }
+    cache = std::make_shared<ResultCache>(directory);
+    Py_RETURN_NONE;
+}
+
+PyObject* cacheInfoMethod(PyObject*, PyObject*) {
+    return Py_BuildValue("{s:n,s:n}", "hits", static_cast<Py_ssize_t>(cache->hits()),
+                         "misses", static_cast<Py_ssize_t>(cache->misses()));
+}
+
+PyMethodDef methods[] = {
+    {"simulate", simulateMethod, METH_VARARGS,
+     "simulate(policy, simulation_end, processes) -> dict\n\n"
+     "Runs a policy spec such as \"1\", \"2-4\" or \"8-1\" over (name, arrival, service) tuples\n"
+     "(name, arrival, priority for Aging; name, arrival, service, priority for 10 and 11) and\n"
+     "returns the run with buffer-protocol arrays."},
+    {"set_cache_dir", setCacheDirMethod, METH_VARARGS,
+     "set_cache_dir(path)\n\nKeeps cached results in path as well as in memory (starts a fresh cache)."},
+    {"cache_info", cacheInfoMethod, METH_NOARGS, "cache_info() -> {'hits': n, 'misses': n}"},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+PyModuleDef moduleDef = {PyModuleDef_HEAD_INIT, "schedsim", "In-process scheduling policy simulator.", -1, methods};
+
+}  // namespace
+
+PyMODINIT_FUNC PyInit_schedsim() {
+    ArrayType.tp_basicsize = sizeof(ArrayObject);
+    ArrayType.tp_flags = Py_TPFLAGS_DEFAULT;
+    ArrayType.tp_doc = "Read-only array exported through the buffer protocol.";
+    ArrayType.tp_dealloc = arrayDealloc;
+    ArrayType.tp_as_buffer = &arrayBufferProcs;
+    ArrayType.tp_as_sequence = &arraySequenceMethods;
+    if (PyType_Ready(&ArrayType) < 0) {
+        return nullptr;
+    }
+
+    PyObject* module = PyModule_Create(&moduleDef);
+    if (!module) {
+        return nullptr;
+    }
+    Py_INCREF(&ArrayType);
+    if (PyModule_AddObject(module, "Array", reinterpret_cast<PyObject*>(&ArrayType)) < 0 ||
+        PyModule_AddIntConstant(module, "IDLE", Idle) < 0 ||
+        PyModule_AddIntConstant(module, "READY", Ready) < 0 ||
+        PyModule_AddIntConstant(module, "RUNNING", Running) < 0) {
+        Py_DECREF(module);
+        return nullptr;
+    }
+    return module;
+}
@@ -0,0 +1,302 @@
+#include "scheduler.h"
+
+#include <fstream>
+#include <cstdio>
+#include <sys/stat.h>
+#include <unistd.h>
+
+std::unique_ptr<Policy> createPolicy(const std::string& policy, std::string& name) {
+    size_t dash = policy.find('-');
+    std::string id = policy.substr(0, dash);
+    int quantum = dash == std::string::npos ? 0 : std::stoi(policy.substr(dash + 1));
+
+    if (id == "1") { name = "FCFS"; return std::make_unique<FCFS>(); }
+    if (id == "3") { name = "SPN"; return std::make_unique<SPN>(); }
+    if (id == "4") { name = "SRT"; return std::make_unique<SRT>(); }
+    if (id == "5") { name = "HRRN"; return std::make_unique<HRRN>(); }
+    if (id == "6") { name = "FB-1"; return std::make_unique<Feedback1>(); }
+    if (id == "7") { name = "FB-2i"; return std::make_unique<Feedback2i>(); }
+    if (id == "2" && quantum > 0) {
+        auto rr = std::make_unique<RoundRobin>();
+        rr->setQuantum(quantum);
+        name = "RR-" + std::to_string(quantum);
+        return rr;
+    }
+    if (id == "9") {
+        auto adaptive = std::make_unique<AdaptiveRoundRobin>();
+        adaptive->setRoundTarget(quantum);
+        name = quantum > 0 ? "ARR-" + std::to_string(quantum) : "ARR";
+        return adaptive;
+    }
+    if (id == "10") {
+        name = quantum > 0 ? "PRIO-" + std::to_string(quantum) : "PRIO";
+        return std::make_unique<PriorityScheduling>(false, quantum);
+    }
+    if (id == "11" && (quantum > 0 || dash == std::string::npos)) {
+        quantum = std::max(quantum, 1);
+        name = "O1-" + std::to_string(quantum);
+        return std::make_unique<PriorityScheduling>(true, quantum);
+    }
+    if (id == "8" && quantum > 0) {
+        auto aging = std::make_unique<Aging>();
+        aging->setQuantum(quantum);
+        name = "Aging";
+        return aging;
+    }
+    return nullptr;
+}
+
+bool simulate(const std::vector<Process>& processes, const std::string& policy, int simulationEnd, SimulationResult& result) {
+    std::unique_ptr<Policy> run;
+    try {
+        run = createPolicy(policy, result.policy);
+    } catch (const std::exception&) {
+        // Malformed quantum such as "2-x".
+    }
+    if (!run) {
+        return false;
+    }
+    for (const auto& process : processes) {
+        run->addProcess(process);
+    }
+    run->executeTrace(simulationEnd, false);
+
+    result.simulationEnd = simulationEnd;
+    result.hasStats = policy[0] != '8';
+    result.processes = run->getProcesses();
+    result.timeline = run->getTimeline();
+    result.quantumTrajectory = run->getQuantumTrajectory();
+    return true;
+}
+
+// ----------------------------------------
+namespace {
+
+const char cacheMagic[8] = {'S', 'C', 'H', 'E', 'D', 'R', 'C', '1'};
+
+// Canonical text of a run's inputs. The process order stays as given because it decides
+// tie-breaks; only the columns the policy reads are kept.
+std::string cacheKey(const std::vector<Process>& processes, const std::string& policy, int simulationEnd) {
+    size_t dash = policy.find('-');
+    std::string id = policy.substr(0, dash);
+    std::string key = "engine " + std::to_string(engineVersion) + "\npolicy " + id;
+    if (dash != std::string::npos) {
+        key += "-" + std::to_string(std::stoi(policy.substr(dash + 1)));
+    }
+    key += "\nend " + std::to_string(simulationEnd) + "\n";
+    bool aging = id == "8";
+    bool prioritized = isPriorityPolicy(id);
+    for (const auto& process : processes) {
+        key += process.name;
+        key += "," + std::to_string(process.arrivalTime) + "," +
+               std::to_string(aging ? process.initialPriority : process.serviceTime);
+        if (prioritized) {
+            key += "," + std::to_string(process.initialPriority);
+        }
+        key += "\n";
+    }
+    return key;
+}
+
+uint64_t fnv1a(const std::string& text) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : text) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    return hash;
+}
+
+void writeU32(std::ostream& out, uint32_t value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void writeString(std::ostream& out, const std::string& text) {
+    writeU32(out, static_cast<uint32_t>(text.size()));
+    out.write(text.data(), text.size());
+}
+
+bool readU32(std::istream& in, uint32_t& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+bool readString(std::istream& in, std::string& text, uint32_t limit) {
+    uint32_t length;
+    if (!readU32(in, length) || length > limit) {
+        return false;
+    }
+    text.resize(length);
+    return static_cast<bool>(in.read(text.data(), length));
+}
+
+// Entry file: magic, engine version, key, then the result. Host byte order, like trace files.
+bool writeEntry(const std::string& path, const std::string& key, const SimulationResult& result) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(cacheMagic, sizeof(cacheMagic));
+    writeU32(out, engineVersion);
+    writeString(out, key);
+    writeString(out, result.policy);
+    writeU32(out, static_cast<uint32_t>(result.simulationEnd));
+    writeU32(out, result.hasStats ? 1 : 0);
+    writeU32(out, static_cast<uint32_t>(result.processes.size()));
+    for (const auto& process : result.processes) {
+        int32_t fields[6] = {process.name, process.arrivalTime, process.serviceTime,
+                             process.finishTime, process.initialPriority, process.priority};
+        out.write(reinterpret_cast<const char*>(fields), sizeof(fields));
+    }
+    for (const auto& row : result.timeline) {
+        out.write(row.data(), row.size());
+    }
+    writeU32(out, static_cast<uint32_t>(result.quantumTrajectory.size()));
+    for (const auto& change : result.quantumTrajectory) {
+        writeU32(out, static_cast<uint32_t>(change.time));
+        writeU32(out, static_cast<uint32_t>(change.quantum));
+    }
+    return static_cast<bool>(out.flush());
+}
+
+// Reads an entry only if it was stored under this key for this horizon and process count, so a
+// corrupt or colliding file never yields a result of the wrong shape.
+bool readEntry(const std::string& path, const std::string& key, int expectedEnd, size_t expectedCount,
+               SimulationResult& result) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[sizeof(cacheMagic)];
+    uint32_t version, simulationEnd, hasStats, count;
+    std::string storedKey;
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, cacheMagic, sizeof(magic)) != 0 ||
+        !readU32(in, version) || version != engineVersion ||
+        !readString(in, storedKey, key.size()) || storedKey != key ||
+        !readString(in, result.policy, 64) || !readU32(in, simulationEnd) || !readU32(in, hasStats) ||
+        !readU32(in, count) || simulationEnd != static_cast<uint32_t>(expectedEnd) || count != expectedCount) {
+        return false;
+    }
+    result.simulationEnd = static_cast<int>(simulationEnd);
+    result.hasStats = hasStats != 0;
+    result.processes.assign(count, Process());
+    for (auto& process : result.processes) {
+        int32_t fields[6];
+        if (!in.read(reinterpret_cast<char*>(fields), sizeof(fields))) {
+            return false;
+        }
+        process.name = static_cast<char>(fields[0]);
+        process.arrivalTime = fields[1];
+        process.serviceTime = fields[2];
+        process.finishTime = fields[3];
+        process.initialPriority = fields[4];
+        process.priority = fields[5];
+    }
+    result.timeline.assign(count, std::vector<char>(simulationEnd));
+    for (auto& row : result.timeline) {
+        if (!in.read(row.data(), row.size())) {
+            return false;
+        }
+    }
+    uint32_t changes;
+    if (!readU32(in, changes) || changes > simulationEnd + 1) {
+        return false;
+    }
+    result.quantumTrajectory.assign(changes, QuantumChange());
+    for (auto& change : result.quantumTrajectory) {
+        uint32_t time, quantum;
+        if (!readU32(in, time) || !readU32(in, quantum)) {
+            return false;
+        }
+        change.time = static_cast<int>(time);
+        change.quantum = static_cast<int>(quantum);
+    }
+    return true;
+}
+
+// Approximate memory held by a cached entry: the timeline dominates on long runs.
+size_t entryBytes(const std::string& key, const SimulationResult& result) {
+    size_t size = key.size() + result.policy.size() + result.processes.size() * sizeof(Process) +
+                  result.quantumTrajectory.size() * sizeof(QuantumChange);
+    for (const auto& row : result.timeline) {
+        size += row.size() + sizeof(row);
+    }
+    return size;
+}
+
+}  // namespace
+
+ResultCache::ResultCache(std::string directory, size_t capacityBytes) : directory(std::move(directory)), capacityBytes(capacityBytes) {
+    if (!this->directory.empty()) {
+        mkdir(this->directory.c_str(), 0755);
+    }
+}
+
+std::string ResultCache::pathFor(const std::string& key) const {
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(fnv1a(key)));
+    return directory + "/" + name;
+}
+
+void ResultCache::remember(const std::string& key, std::shared_ptr<const SimulationResult> result) {
+    size_t size = entryBytes(key, *result);
+    if (size > capacityBytes) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!entries.emplace(key, std::move(result)).second) {
+        return;
+    }
+    insertionOrder.emplace_back(key, size);
+    bytes += size;
+    while (bytes > capacityBytes) {
+        entries.erase(insertionOrder.front().first);
+        bytes -= insertionOrder.front().second;
+        insertionOrder.pop_front();
+    }
+}
+
+bool ResultCache::lookup(const std::vector<Process>& processes, const std::string& policy, int simulationEnd, SimulationResult& result) {
+    std::string key = cacheKey(processes, policy, simulationEnd);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(key);
+        if (it != entries.end()) {
+            result = *it->second;
+            ++hitCount;
+            return true;
+        }
+    }
+    if (!directory.empty() && readEntry(pathFor(key), key, simulationEnd, processes.size(), result)) {
+        remember(key, std::make_shared<const SimulationResult>(result));
+        ++hitCount;
+        return true;
+    }
+    ++missCount;
+    return false;
+}
+
+void ResultCache::store(const std::vector<Process>& processes, const std::string& policy, int simulationEnd, const SimulationResult& result) {
+    std::string key = cacheKey(processes, policy, simulationEnd);
+    remember(key, std::make_shared<const SimulationResult>(result));
+    if (directory.empty()) {
+        return;
+    }
+    // Written under a unique name and renamed, so concurrent writers and readers never see a
+    // partial entry.
+    static std::atomic<unsigned> sequence{0};
+    std::string path = pathFor(key);
+    std::string temporary = path + ".tmp" + std::to_string(getpid()) + "-" + std::to_string(sequence++);
+    if (writeEntry(temporary, key, result)) {
+        std::rename(temporary.c_str(), path.c_str());
+    } else {
+        std::remove(temporary.c_str());
+    }
+}
+
+bool ResultCache::simulate(const std::vector<Process>& processes, const std::string& policy, int simulationEnd, SimulationResult& result) {
+    try {
+        if (lookup(processes, policy, simulationEnd, result)) {
+            return true;
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    if (!::simulate(processes, policy, simulationEnd, result)) {
+        return false;
+    }
+    store(processes, policy, simulationEnd, result);
+    return true;
+}
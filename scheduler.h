@@ -0,0 +1,2439 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+// Simulation library: the reference scheduling policies, the online engine and the simulate()
+// entry point shared by the lab6 command line and the schedsim Python module.
+#include <iostream>
+#include <vector>
+#include <queue>
+#include <deque>
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <charconv>
+#include <memory>
+#include <functional>
+#include <cstdint>
+#include <cmath>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <map>
+#include <limits>
+
+struct Process {
+    char name;
+    int arrivalTime = 0;
+    int serviceTime = 0;
+    int finishTime = 0;
+    int initialPriority = 0;
+    int priority = 0;
+
+    bool operator==(const Process& other) const 
+    {
+        return name == other.name && arrivalTime == other.arrivalTime && serviceTime == other.serviceTime;
+    }
+};
+
+// The quantum a policy switched to at a given time.
+struct QuantumChange {
+    int time;
+    int quantum;
+};
+
+// One finished run: the processes with their finish times, the per-tick schedule and, for
+// adaptive policies, the quantum changes. hasStats is false when the third input column is a
+// priority rather than a service time (Aging).
+struct SimulationResult {
+    std::string policy;
+    int simulationEnd = 0;
+    bool hasStats = true;
+    std::vector<Process> processes;
+    std::vector<std::vector<char>> timeline;
+    std::vector<QuantumChange> quantumTrajectory;
+};
+
+// Energy of a run under a SpeedModel; perProcess is empty when none was used.
+struct EnergyReport {
+    std::vector<double> perProcess;  // dynamic energy of the ticks each process ran
+    double total = 0;                // dynamic plus static energy of every simulated tick
+    double staticEnergy = 0;
+    double meanFrequency = 0;
+    std::vector<uint8_t> levels;     // frequency level of every tick up to the horizon
+};
+
+// Priority policies ("10" static, "11" O(1)) read a fourth input column; higher values run first.
+inline bool isPriorityPolicy(const std::string& policy) {
+    std::string id = policy.substr(0, policy.find('-'));
+    return id == "10" || id == "11";
+}
+
+// Priorities map one to one onto the run queue levels, so inputs outside them are rejected.
+constexpr int priorityLevels = 64;
+
+inline bool isValidPriority(int priority) {
+    return priority >= 0 && priority < priorityLevels;
+}
+
+// Outcome of the processes sharing one priority. Unfinished processes are only counted, since
+// starvation shows up there first.
+struct PriorityClassStats {
+    int priority = 0;
+    int finished = 0;
+    int unfinished = 0;
+    double meanTurnaround = 0;
+    int maxTurnaround = 0;
+    int maxWait = 0;  // worst turnaround minus service: longest a process was kept off the CPU
+    double meanNormTurn = 0;
+};
+
+// One entry per priority present in processes, highest priority first.
+inline std::vector<PriorityClassStats> priorityClassStats(const std::vector<Process>& processes) {
+    std::map<int, PriorityClassStats, std::greater<int>> classes;
+    for (const Process& process : processes) {
+        PriorityClassStats& stats = classes[process.initialPriority];
+        stats.priority = process.initialPriority;
+        if (process.finishTime == 0) {
+            ++stats.unfinished;
+            continue;
+        }
+        int turnaround = process.finishTime - process.arrivalTime;
+        ++stats.finished;
+        stats.meanTurnaround += turnaround;
+        stats.meanNormTurn += double(turnaround) / process.serviceTime;
+        stats.maxTurnaround = std::max(stats.maxTurnaround, turnaround);
+        stats.maxWait = std::max(stats.maxWait, turnaround - process.serviceTime);
+    }
+    std::vector<PriorityClassStats> result;
+    for (auto& entry : classes) {
+        PriorityClassStats& stats = entry.second;
+        if (stats.finished > 0) {
+            stats.meanTurnaround /= stats.finished;
+            stats.meanNormTurn /= stats.finished;
+        }
+        result.push_back(stats);
+    }
+    return result;
+}
+
+class Policy {
+protected:
+    std::vector<Process> processes;
+    std::vector<std::vector<char>> timeline;
+    std::vector<QuantumChange> quantumTrajectory;
+    EnergyReport energy;
+    std::ostream* output = &std::cout;
+
+    static const size_t statsCellWidth = 32;
+
+    static char* appendText(char* p, const char* text, size_t length) {
+        std::memcpy(p, text, length);
+        return p + length;
+    }
+
+    template <size_t N>
+    static char* appendText(char* p, const char (&text)[N]) {
+        return appendText(p, text, N - 1);
+    }
+
+    // Right-aligns like std::setw: pads to width but never truncates.
+    static char* appendPadded(char* p, const char* digits, size_t length, size_t width) {
+        if (length < width) {
+            std::memset(p, ' ', width - length);
+            p += width - length;
+        }
+        return appendText(p, digits, length);
+    }
+
+    static char* appendInt(char* p, long long value, size_t width) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        return appendPadded(p, digits, result.ptr - digits, width);
+    }
+
+    static char* appendFixed(char* p, double value, size_t width) {
+        char digits[statsCellWidth];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::fixed, 2);
+        if (result.ec != std::errc()) {
+            return appendText(p, " huge");
+        }
+        return appendPadded(p, digits, result.ptr - digits, width);
+    }
+
+public:
+    virtual void executeTrace(int simulationEnd,bool trace) = 0;
+    // Title of the trace table, padded to the width of the process column.
+    virtual std::string traceLabel() const = 0;
+    // True when the stats break turnaround down per priority class.
+    virtual bool prioritized() const {
+        return false;
+    }
+    virtual ~Policy() = default;
+
+    void addProcess(const Process& process) {
+        processes.push_back(process);
+    };
+
+    void setOutput(std::ostream& out) {
+        output = &out;
+    }
+
+    const std::vector<Process>& getProcesses() const {
+        return processes;
+    }
+
+    // Per-process state of the last run, one cell per tick: '*' executing, '.' ready.
+    const std::vector<std::vector<char>>& getTimeline() const {
+        return timeline;
+    }
+
+    // Quantum changes of the last run; empty for policies without an adaptive quantum.
+    const std::vector<QuantumChange>& getQuantumTrajectory() const {
+        return quantumTrajectory;
+    }
+
+    const EnergyReport& getEnergy() const {
+        return energy;
+    }
+
+    // Loads a run produced earlier (e.g. from a ResultCache) in place of executeTrace.
+    void restore(const SimulationResult& result) {
+        processes = result.processes;
+        timeline = result.timeline;
+        quantumTrajectory = result.quantumTrajectory;
+    }
+
+    void displayTrace(int simulationEnd) {
+        displayTraceTimeline(traceLabel(), processes, timeline, simulationEnd);
+    }
+
+    void executeStats(std::string policy) {
+        const size_t n = processes.size();
+
+        // Struct-of-arrays copy so the metric loops below run over contiguous ints and doubles.
+        std::vector<int> arrival(n), service(n), finish(n), turnaround(n);
+        std::vector<double> normTurn(n);
+        for (size_t i = 0; i < n; ++i) {
+            arrival[i] = processes[i].arrivalTime;
+            service[i] = processes[i].serviceTime;
+            finish[i] = processes[i].finishTime;
+        }
+
+        long long turnaroundSum = 0;
+        for (size_t i = 0; i < n; ++i) {
+            turnaround[i] = finish[i] - arrival[i];
+            turnaroundSum += turnaround[i];
+        }
+        for (size_t i = 0; i < n; ++i) {
+            normTurn[i] = double(turnaround[i]) / service[i];
+        }
+
+        // Four independent partial sums keep the reduction vectorizable and reduce rounding drift.
+        double lanes[4] = {0, 0, 0, 0};
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            lanes[0] += normTurn[i];
+            lanes[1] += normTurn[i + 1];
+            lanes[2] += normTurn[i + 2];
+            lanes[3] += normTurn[i + 3];
+        }
+        for (; i < n; ++i) {
+            lanes[0] += normTurn[i];
+        }
+        double normTurnSum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+
+        std::vector<PriorityClassStats> classes;
+        if (prioritized()) {
+            classes = priorityClassStats(processes);
+        }
+
+        // Every cell is at most statsCellWidth characters, so one allocation holds the whole table.
+        std::string table(policy.size() + 336 + (n * 8 + quantumTrajectory.size() * 2 + classes.size() * 7) * statsCellWidth, '\0');
+        char* p = table.data();
+        p = appendText(p, policy.data(), policy.size());
+        p = appendText(p, "\nProcess    |");
+        for (size_t i = 0; i < n; ++i) {
+            p = appendText(p, "  ");
+            *p++ = processes[i].name;
+            p = appendText(p, "  |");
+        }
+
+        p = appendText(p, "\nArrival    |");
+        for (size_t i = 0; i < n; ++i) {
+            p = appendText(p, "  ");
+            p = appendInt(p, arrival[i], 0);
+            p = appendText(p, "  |");
+        }
+
+        if (prioritized()) {
+            p = appendText(p, "\nPriority   |");
+            for (size_t i = 0; i < n; ++i) {
+                p = appendText(p, "  ");
+                p = appendInt(p, processes[i].initialPriority, 0);
+                p = appendText(p, "  |");
+            }
+        }
+
+        p = appendText(p, "\nService    |");
+        for (size_t i = 0; i < n; ++i) {
+            p = appendText(p, "  ");
+            p = appendInt(p, service[i], 0);
+            p = appendText(p, "  |");
+        }
+        p = appendText(p, " Mean|");
+
+        p = appendText(p, "\nFinish     |");
+        for (size_t i = 0; i < n; ++i) {
+            p = appendInt(p, finish[i], 3);
+            p = appendText(p, "  |");
+        }
+        p = appendText(p, "-----|");
+
+        p = appendText(p, "\nTurnaround |");
+        for (size_t i = 0; i < n; ++i) {
+            p = appendInt(p, turnaround[i], 3);
+            p = appendText(p, "  |");
+        }
+        p = appendFixed(p, double(turnaroundSum) / n, 5);
+        p = appendText(p, "|");
+
+        p = appendText(p, "\nNormTurn   |");
+        for (size_t i = 0; i < n; ++i) {
+            p = appendFixed(p, normTurn[i], 5);
+            *p++ = '|';
+        }
+        p = appendFixed(p, normTurnSum / n, 5);
+        p = appendText(p, "|\n");
+
+        if (!classes.empty()) {
+            p = appendText(p, "Class      |");
+            for (const auto& c : classes) {
+                p = appendInt(p, c.priority, 5);
+                *p++ = '|';
+            }
+            p = appendText(p, "\nFinished   |");
+            for (const auto& c : classes) {
+                p = appendInt(p, c.finished, 5);
+                *p++ = '|';
+            }
+            p = appendText(p, "\nUnfinished |");
+            for (const auto& c : classes) {
+                p = appendInt(p, c.unfinished, 5);
+                *p++ = '|';
+            }
+            p = appendText(p, "\nMean turn  |");
+            for (const auto& c : classes) {
+                p = appendFixed(p, c.meanTurnaround, 5);
+                *p++ = '|';
+            }
+            p = appendText(p, "\nWorst turn |");
+            for (const auto& c : classes) {
+                p = appendInt(p, c.maxTurnaround, 5);
+                *p++ = '|';
+            }
+            p = appendText(p, "\nMax wait   |");
+            for (const auto& c : classes) {
+                p = appendInt(p, c.maxWait, 5);
+                *p++ = '|';
+            }
+            p = appendText(p, "\nMean norm  |");
+            for (const auto& c : classes) {
+                p = appendFixed(p, c.meanNormTurn, 5);
+                *p++ = '|';
+            }
+            *p++ = '\n';
+        }
+
+        if (!quantumTrajectory.empty()) {
+            p = appendText(p, "Quantum    |");
+            for (const auto& change : quantumTrajectory) {
+                p = appendInt(p, change.time, 0);
+                *p++ = ':';
+                p = appendInt(p, change.quantum, 0);
+                *p++ = ' ';
+            }
+            *p++ = '\n';
+        }
+
+        if (!energy.perProcess.empty()) {
+            double energySum = 0;
+            p = appendText(p, "Energy     |");
+            for (size_t i = 0; i < n; ++i) {
+                p = appendFixed(p, energy.perProcess[i], 5);
+                *p++ = '|';
+                energySum += energy.perProcess[i];
+            }
+            p = appendFixed(p, energySum / n, 5);
+            p = appendText(p, "|\nTotal energy ");
+            p = appendFixed(p, energy.total, 0);
+            p = appendText(p, " (static ");
+            p = appendFixed(p, energy.staticEnergy, 0);
+            p = appendText(p, "), mean frequency ");
+            p = appendInt(p, std::llround(energy.meanFrequency), 0);
+            p = appendText(p, " MHz\n");
+        }
+        *p++ = '\n';
+
+        output->write(table.data(), p - table.data());
+    }
+
+
+    void displayTraceTimeline(std::string policy, const std::vector<Process>& processes, const std::vector<std::vector<char>>& timeline, int simulationEnd) {
+    *output << policy;
+    for (int t = 0; t < simulationEnd+1; ++t) {
+        *output << t % 10 << " ";
+    }
+    *output << "\n" << std::string(simulationEnd * 2 + 8, '-') << "\n";
+
+    for (size_t i = 0; i < processes.size(); ++i) {
+        *output << processes[i].name << "     ";
+        for (int t = 0; t < simulationEnd; ++t) {
+            if (timeline[i][t] == '*' || timeline[i][t] == '.') {
+                *output << "|" << timeline[i][t];
+            } else {
+                *output << "| ";
+            }
+
+            if(t == simulationEnd - 1) {
+                *output << "| ";
+            }
+        }
+        *output << "\n";
+    }
+
+    // Frequency level of every tick under a speed model (0 = lowest).
+    if (!energy.levels.empty()) {
+        *output << "f     ";
+        for (int t = 0; t < simulationEnd; ++t) {
+            *output << "|";
+            if (t < (int)energy.levels.size()) {
+                *output << int(energy.levels[t]);
+            } else {
+                *output << " ";
+            }
+        }
+        *output << "| \n";
+    }
+
+    *output << std::string(simulationEnd * 2 + 8, '-') << "\n";
+    *output << "\n";
+}
+
+};
+
+// ----------------------------------------
+class FCFS : public Policy {
+public:
+    std::string traceLabel() const override {
+        return "FCFS  ";
+    }
+
+    void executeTrace(int simulationEnd, bool trace) {
+        std::vector<Process> readyQueue;
+        Process currentProcess;
+        bool isExecuting = false;
+        int currentTime = 0;
+
+        timeline.assign(processes.size(), std::vector<char>(simulationEnd, ' '));
+
+        while (currentTime < simulationEnd) {
+            for (size_t i = 0; i < processes.size(); ++i) {
+                if (processes[i].arrivalTime == currentTime) {
+                    readyQueue.push_back(processes[i]);
+                }
+            }
+
+            for (size_t i = 0; i < processes.size(); ++i) {
+                if (std::find_if(readyQueue.begin(), readyQueue.end(), [&](const Process& p) { return p.name == processes[i].name; }) != readyQueue.end()) {
+                    timeline[i][currentTime] = '.';
+                }
+            }
+
+            if (!isExecuting && !readyQueue.empty()) {
+                currentProcess = readyQueue.front();
+                isExecuting = true;
+            }
+
+            if (isExecuting) {
+                auto it = std::find_if(processes.begin(), processes.end(), [&](const Process& p) { return p.name == currentProcess.name; });
+                size_t index = std::distance(processes.begin(), it);
+                timeline[index][currentTime] = '*';
+                --currentProcess.serviceTime;
+
+                if (currentProcess.serviceTime == 0) {
+                    for(auto& process : processes) {
+                        if(process.name == currentProcess.name)
+                            process.finishTime = currentTime + 1;
+                    }
+                    currentProcess.finishTime = currentTime + 1;
+                    readyQueue.erase(readyQueue.begin());
+                    isExecuting = false;
+                }
+            }
+            ++currentTime;
+        }
+
+        if(trace)
+            displayTraceTimeline(traceLabel(), processes, timeline, simulationEnd);
+    }
+};
+
+// ----------------------------------------
+class RoundRobin : public Policy{
+private:
+    int quantum;
+
+public:
+    void setQuantum(int q) {
+        quantum = q;    
+    }
+
+    std::string traceLabel() const override {
+        return "RR-" + std::to_string(quantum) + "  ";
+    }
+
+void executeTrace(int simulationEnd, bool trace) {
+    std::queue<Process> readyQueue;
+    int currentTime = 0;
+    
+    Process temp;
+    int pushTime = -1;
+
+    timeline.assign(processes.size(), std::vector<char>(simulationEnd, ' '));
+    std::vector<bool> isInQueue(processes.size(), false);
+
+    while (currentTime < simulationEnd) {
+        for (size_t i = 0; i < processes.size(); ++i) {
+            if (processes[i].arrivalTime <= currentTime && !isInQueue[i]) {
+                readyQueue.push(processes[i]);
+                isInQueue[i] = true;
+            }
+        }
+
+        if(pushTime == currentTime) {
+            readyQueue.push(temp);
+        }
+
+        if (!readyQueue.empty()) {
+            Process currentProcess = readyQueue.front();
+            readyQueue.pop();
+
+            int executionTime = std::min(quantum, currentProcess.serviceTime);
+            currentProcess.serviceTime -= executionTime;
+
+            for (size_t i = 0; i < processes.size(); ++i) {
+            if (processes[i].arrivalTime <= currentTime+executionTime && !isInQueue[i]) {
+                readyQueue.push(processes[i]);
+                isInQueue[i] = true;
+            }
+        }
+
+            for (int t = 0; t < executionTime; ++t) {
+                auto it = std::find_if(processes.begin(), processes.end(), [&](const Process& p) {
+                    return p.name == currentProcess.name;
+                });
+                size_t index = std::distance(processes.begin(), it);
+                if (currentTime + t < simulationEnd) {
+                    timeline[index][currentTime + t] = '*';
+                }
+
+                std::queue<Process> tempQueue = readyQueue; 
+                while (!tempQueue.empty()) {
+                    Process queuedProcess = tempQueue.front();
+                    tempQueue.pop();
+
+                    auto queuedIt = std::find_if(processes.begin(), processes.end(), [&](const Process& p) {
+                        return p.name == queuedProcess.name;
+                    });
+                    size_t queuedIndex = std::distance(processes.begin(), queuedIt);
+
+                    if (currentTime + t >= processes[queuedIndex].arrivalTime && currentTime + t < simulationEnd) {   
+                        timeline[queuedIndex][currentTime + t] = '.';
+                    }
+                }
+            }
+
+            currentTime += executionTime;
+
+            if (currentProcess.serviceTime > 0) {
+                temp = currentProcess;
+                pushTime = currentTime;
+            } else {
+                auto it = std::find_if(processes.begin(), processes.end(), [&](const Process& p) {
+                    return p.name == currentProcess.name;
+                });
+                if (it != processes.end()) {
+                    it->finishTime = currentTime;
+                }
+            }
+        } else {
+            ++currentTime;
+        }
+    }
+
+    if (trace) {
+        displayTraceTimeline(traceLabel(), processes, timeline, simulationEnd);
+    }
+}
+
+};
+
+// ----------------------------------------
+// Round Robin whose quantum follows the workload instead of a fixed setting. The scheduler does
+// not know how much service a job still needs, so at every dispatch the quantum is the
+// burstPercentile-th percentile of the bursts of the last burstWindow finished jobs (the CPU
+// time they actually received), and initialQuantum until the first job finishes. Most jobs
+// then finish within one slice and short bursts are not chopped up. The quantum is also capped
+// at L / (ready jobs), so a long queue still gets round the CPU within about L ticks instead of
+// degrading to FCFS; L is defaultRoundTarget, or the round target of policy "9-L".
+class AdaptiveRoundRobin : public Policy {
+private:
+    static const int burstPercentile = 80;
+    static const int initialQuantum = 4;
+    static const int defaultRoundTarget = 20;
+    static const size_t burstWindow = 32;
+    int roundTarget = 0;
+
+    int chooseQuantum(const std::deque<int>& finishedBursts, size_t readyCount) const {
+        int quantum = initialQuantum;
+        if (!finishedBursts.empty()) {
+            std::vector<int> bursts(finishedBursts.begin(), finishedBursts.end());
+            size_t rank = (bursts.size() * burstPercentile + 99) / 100;
+            rank = std::max<size_t>(rank, 1) - 1;
+            std::nth_element(bursts.begin(), bursts.begin() + rank, bursts.end());
+            quantum = bursts[rank];
+        }
+        int target = roundTarget > 0 ? roundTarget : defaultRoundTarget;
+        quantum = std::min(quantum, std::max(1, target / static_cast<int>(readyCount)));
+        return std::max(quantum, 1);
+    }
+
+public:
+    void setRoundTarget(int target) {
+        roundTarget = target;
+    }
+
+    std::string traceLabel() const override {
+        std::string label = roundTarget > 0 ? "ARR-" + std::to_string(roundTarget) : "ARR";
+        label.resize(std::max<size_t>(label.size() + 1, 6), ' ');
+        return label;
+    }
+
+    void executeTrace(int simulationEnd, bool trace) override {
+        std::deque<size_t> ready;
+        std::deque<int> finishedBursts;
+        std::vector<int> remaining(processes.size());
+        std::vector<bool> admitted(processes.size(), false);
+        for (size_t i = 0; i < processes.size(); ++i) {
+            remaining[i] = processes[i].serviceTime;
+        }
+
+        timeline.assign(processes.size(), std::vector<char>(simulationEnd, ' '));
+        quantumTrajectory.clear();
+
+        auto admit = [&](int time) {
+            for (size_t i = 0; i < processes.size(); ++i) {
+                if (!admitted[i] && processes[i].arrivalTime <= time) {
+                    ready.push_back(i);
+                    admitted[i] = true;
+                }
+            }
+        };
+
+        int currentTime = 0;
+        admit(currentTime);
+        while (currentTime < simulationEnd) {
+            if (ready.empty()) {
+                admit(++currentTime);
+                continue;
+            }
+
+            int quantum = chooseQuantum(finishedBursts, ready.size());
+            if (quantumTrajectory.empty() || quantumTrajectory.back().quantum != quantum) {
+                quantumTrajectory.push_back({currentTime, quantum});
+            }
+
+            size_t current = ready.front();
+            ready.pop_front();
+            int executionTime = std::min(quantum, remaining[current]);
+            for (int t = currentTime; t < currentTime + executionTime && t < simulationEnd; ++t) {
+                if (t > currentTime) admit(t);
+                timeline[current][t] = '*';
+                for (size_t index : ready) {
+                    timeline[index][t] = '.';
+                }
+            }
+
+            currentTime += executionTime;
+            remaining[current] -= executionTime;
+            admit(currentTime);
+            if (remaining[current] > 0) {
+                ready.push_back(current);
+            } else {
+                processes[current].finishTime = currentTime;
+                finishedBursts.push_back(processes[current].serviceTime);
+                if (finishedBursts.size() > burstWindow) {
+                    finishedBursts.pop_front();
+                }
+            }
+        }
+
+        if (trace) {
+            displayTraceTimeline(traceLabel(), processes, timeline, simulationEnd);
+        }
+    }
+};
+
+// ----------------------------------------
+class SPN : public Policy {
+public:
+    std::string traceLabel() const override {
+        return "SPN   ";
+    }
+
+    void executeTrace(int simulationEnd, bool trace) override {
+        std::vector<Process> readyQueue;
+        Process currentProcess;
+        bool isExecuting = false;
+        int currentTime = 0;
+
+        timeline.assign(processes.size(), std::vector<char>(simulationEnd, ' '));
+
+        while (currentTime < simulationEnd) {
+            for (size_t i = 0; i < processes.size(); ++i) {
+                if (processes[i].arrivalTime == currentTime) {
+                    readyQueue.push_back(processes[i]);
+                }
+            }
+
+            for (size_t i = 0; i < processes.size(); ++i) {
+                if (std::find_if(readyQueue.begin(), readyQueue.end(), [&](const Process& p) { return p.name == processes[i].name; }) != readyQueue.end()) {
+                    timeline[i][currentTime] = '.';
+                }
+            }
+
+            if (!isExecuting && !readyQueue.empty()) {
+                std::sort(readyQueue.begin(), readyQueue.end(), [](const Process& a, const Process& b) {
+                    return a.serviceTime < b.serviceTime;
+                });
+                currentProcess = readyQueue.front();
+                isExecuting = true;
+            }
+
+            if (isExecuting) {
+                auto it = std::find_if(processes.begin(), processes.end(), [&](const Process& p) { return p.name == currentProcess.name; });
+                size_t index = std::distance(processes.begin(), it);
+                timeline[index][currentTime] = '*';
+                --currentProcess.serviceTime;
+
+                if (currentProcess.serviceTime == 0) {
+                    for(auto& process : processes) {
+                        if(process.name == currentProcess.name)
+                            process.finishTime = currentTime + 1;
+                    }
+                    currentProcess.finishTime = currentTime + 1;
+                    readyQueue.erase(readyQueue.begin());
+                    isExecuting = false;
+                }
+            }
+            ++currentTime;
+        }
+
+        if(trace)
+            displayTraceTimeline(traceLabel(), processes, timeline, simulationEnd);
+    }
+
+};
+
+// ----------------------------------------
+class SRT : public Policy {
+public: 
+    std::string traceLabel() const override {
+        return "SRT   ";
+    }
+
+    void executeTrace(int simulationEnd, bool trace) {
+        std::vector<Process> readyQueue;
+        Process currentProcess;
+        bool isExecuting = false;
+        int currentTime = 0;
+
+        timeline.assign(processes.size(), std::vector<char>(simulationEnd, ' '));
+
+        while (currentTime < simulationEnd) {
+            for (size_t i = 0; i < processes.size(); ++i) {
+                if (processes[i].arrivalTime == currentTime) {
+                    readyQueue.push_back(processes[i]);
+                }
+            }
+
+            for (size_t i = 0; i < processes.size(); ++i) {
+                if (std::find_if(readyQueue.begin(), readyQueue.end(), [&](const Process& p) { return p.name == processes[i].name; }) != readyQueue.end()) {
+                    timeline[i][currentTime] = '.';
+                }
+            }
+
+            if (!isExecuting && !readyQueue.empty()) {
+                std::sort(readyQueue.begin(), readyQueue.end(), [](const Process& a, const Process& b) {
+                    return a.serviceTime < b.serviceTime;
+                });
+                currentProcess = readyQueue.front();
+                isExecuting = true;
+            }
+
+            if (isExecuting) {
+                auto it = std::find_if(processes.begin(), processes.end(), [&](const Process& p) { return p.name == currentProcess.name; });
+                size_t index = std::distance(processes.begin(), it);
+                timeline[index][currentTime] = '*';
+                --currentProcess.serviceTime;
+                readyQueue.front().serviceTime = currentProcess.serviceTime;
+
+                if (currentProcess.serviceTime == 0) {
+                    for(auto& process : processes) {
+                        if(process.name == currentProcess.name)
+                            process.finishTime = currentTime + 1;
+                    }
+                    currentProcess.finishTime = currentTime + 1;
+                    readyQueue.erase(readyQueue.begin());
+                }
+                isExecuting = false;
+            }
+            ++currentTime;
+        }
+
+        if(trace)
+            displayTraceTimeline(traceLabel(), processes, timeline, simulationEnd);
+    }
+};
+
+// ----------------------------------------
+class HRRN : public Policy {
+public:
+    std::string traceLabel() const override {
+        return "HRRN  ";
+    }
+
+    void executeTrace(int simulationEnd, bool trace) override {
+    std::vector<Process> readyQueue;
+    Process currentProcess;
+    bool isExecuting = false;
+    int currentTime = 0;
+
+    timeline.assign(processes.size(), std::vector<char>(simulationEnd, ' '));
+
+    while (currentTime < simulationEnd) {
+        for (size_t i = 0; i < processes.size(); ++i) {
+            if (processes[i].arrivalTime == currentTime) {
+                readyQueue.push_back(processes[i]);
+            }
+        }
+
+        for (size_t i = 0; i < processes.size(); ++i) {
+            if (std::find_if(readyQueue.begin(), readyQueue.end(), [&](const Process& p) { return p.name == processes[i].name; }) != readyQueue.end()) {
+                timeline[i][currentTime] = '.';
+            }
+        }
+
+        if (!isExecuting && !readyQueue.empty()) {
+            float maxRR = -1.0; 
+            size_t selectedIndex = 0;
+
+            for (size_t i = 0; i < readyQueue.size(); ++i) {
+                int waitingTime = currentTime - readyQueue[i].arrivalTime;
+                float responseRatio = (waitingTime + readyQueue[i].serviceTime) / float(readyQueue[i].serviceTime);
+
+                if (responseRatio > maxRR) {
+                    maxRR = responseRatio;
+                    selectedIndex = i;
+                }
+            }
+
+            currentProcess = readyQueue[selectedIndex];
+            readyQueue.erase(readyQueue.begin() + selectedIndex);
+            isExecuting = true;
+        }
+
+        if (isExecuting) {
+            auto it = std::find_if(processes.begin(), processes.end(), [&](const Process& p) { return p.name == currentProcess.name; });
+            size_t index = std::distance(processes.begin(), it);
+            timeline[index][currentTime] = '*';
+            --currentProcess.serviceTime;
+
+            if (currentProcess.serviceTime == 0) {
+                for (auto& process : processes) {
+                    if (process.name == currentProcess.name)
+                        process.finishTime = currentTime + 1;
+                }
+                isExecuting = false;
+            }
+        }
+        ++currentTime;
+    }
+
+    if (trace) {
+        displayTraceTimeline(traceLabel(), processes, timeline, simulationEnd);
+    }
+}
+};
+
+// ----------------------------------------
+class Feedback1 : public Policy {
+public:
+    std::string traceLabel() const override {
+        return "FB-1  ";
+    }
+
+    void executeTrace(int simulationEnd, bool trace) {
+        std::vector<std::queue<Process>> readyQueues;
+        int currentTime = 0;
+        int processNum = 0;
+
+        timeline.assign(processes.size(), std::vector<char>(simulationEnd, ' '));
+
+        std::vector<bool> isInQueue(processes.size(), false);
+
+        Process currentProcess;
+        int remainingQuantum = 0;
+        bool isExecuting = false;
+
+        while (currentTime < simulationEnd) {
+            for (size_t i = 0; i < processes.size(); ++i) {
+                if (processes[i].arrivalTime == currentTime && !isInQueue[i]) {
+                    if (readyQueues.empty()) {
+                        readyQueues.emplace_back(); 
+                    }
+                    readyQueues[0].push(processes[i]);
+                    isInQueue[i] = true;
+                    processNum++;
+                }
+            }
+
+            for (size_t i = 0; i < processes.size(); ++i) {
+                bool inQueue = false;
+                for (const auto& queue : readyQueues) {
+                    std::queue<Process> tempQueue = queue;
+                    while (!tempQueue.empty()) {
+                        if (tempQueue.front().name == processes[i].name) {
+                            inQueue = true;
+                            break;
+                        }
+                        tempQueue.pop();
+                    }
+                    if (inQueue) break;
+                }
+                if (inQueue && !(isExecuting && currentProcess.name == processes[i].name)) {
+                    timeline[i][currentTime] = '.';
+                }
+            }
+
+            if (!isExecuting) {
+                for (size_t i = 0; i < readyQueues.size(); ++i) {
+                    if (!readyQueues[i].empty()) {
+                        currentProcess = readyQueues[i].front();
+                        remainingQuantum = 1; 
+                        isExecuting = true;
+                        break;
+                    }
+                    else if(processNum == 1 && i + 1 < readyQueues.size() && !readyQueues[i+1].empty()) {
+                        if(i == 0) {
+                            readyQueues[i].push(readyQueues[i+1].front());
+                            readyQueues[i+1].pop();
+                            currentProcess = readyQueues[i].front();
+                            remainingQuantum = 1 << i;
+                            isExecuting = true;
+                            break;
+                        }
+                    }
+                }
+            }
+
+            if (isExecuting) {
+                auto it = std::find_if(processes.begin(), processes.end(), [&](const Process& p) {
+                    return p.name == currentProcess.name;
+                });
+                size_t index = std::distance(processes.begin(), it);
+                timeline[index][currentTime] = '*';
+
+                --currentProcess.serviceTime;
+                --remainingQuantum;
+                
+                if (currentProcess.serviceTime == 0 || remainingQuantum == 0) {
+                    for (size_t i = 0; i < readyQueues.size(); ++i) {
+                        if (!readyQueues[i].empty() && readyQueues[i].front().name == currentProcess.name) {
+                            readyQueues[i].pop();
+                            if (remainingQuantum == 0 && currentProcess.serviceTime > 0) {
+                                size_t nextQueueIndex = i + 1;
+                                if (nextQueueIndex >= readyQueues.size()) {
+                                    readyQueues.emplace_back(); 
+                                }
+                                readyQueues[nextQueueIndex].push(currentProcess); 
+                            } else if (currentProcess.serviceTime == 0) {
+                                auto it = std::find_if(processes.begin(), processes.end(), [&](const Process& p) {
+                                    return p.name == currentProcess.name;
+                                });
+                                if (it != processes.end()) {
+                                    it->finishTime = currentTime + 1;
+                                }
+                            }
+                            break;
+                        }
+                    }
+                    isExecuting = false;
+                }
+            }
+            ++currentTime;
+        }
+
+        if (trace) {
+            displayTraceTimeline(traceLabel(), processes, timeline, simulationEnd);
+        }
+    }
+};
+
+// ----------------------------------------
+class Feedback2i : public Policy {
+public:
+    std::string traceLabel() const override {
+        return "FB-2i ";
+    }
+
+    void executeTrace(int simulationEnd, bool trace) override {
+        std::vector<std::queue<Process>> readyQueues;
+        int currentTime = 0;
+        int processNum = 0;
+
+        timeline.assign(processes.size(), std::vector<char>(simulationEnd, ' '));
+
+        std::vector<bool> isInQueue(processes.size(), false);
+
+        Process currentProcess;
+        int remainingQuantum = 0;
+        bool isExecuting = false;
+
+        while (currentTime < simulationEnd) {
+            for (size_t i = 0; i < processes.size(); ++i) {
+                if (processes[i].arrivalTime == currentTime && !isInQueue[i]) {
+                    if (readyQueues.empty()) {
+                        readyQueues.emplace_back(); 
+                    }
+                    readyQueues[0].push(processes[i]);
+                    isInQueue[i] = true;
+                    processNum++;
+                }
+            }
+
+            for (size_t i = 0; i < processes.size(); ++i) {
+                bool inQueue = false;
+                for (const auto& queue : readyQueues) {
+                    std::queue<Process> tempQueue = queue;
+                    while (!tempQueue.empty()) {
+                        if (tempQueue.front().name == processes[i].name) {
+                            inQueue = true;
+                            break;
+                        }
+                        tempQueue.pop();
+                    }
+                    if (inQueue) break;
+                }
+                if (inQueue && !(isExecuting && currentProcess.name == processes[i].name)) {
+                    timeline[i][currentTime] = '.';
+                }
+            }
+
+            if (!isExecuting) {
+                for (size_t i = 0; i < readyQueues.size(); ++i) {
+                    if (!readyQueues[i].empty()) {
+                        currentProcess = readyQueues[i].front();
+                        remainingQuantum = 1 << i; 
+                        isExecuting = true;
+                        break;
+                    }
+                    else if(processNum == 1 && i + 1 < readyQueues.size() && !readyQueues[i+1].empty()) {
+                        if(i == 0) {
+                            readyQueues[i].push(readyQueues[i+1].front());
+                            readyQueues[i+1].pop();
+                            currentProcess = readyQueues[i].front();
+                            remainingQuantum = 1 << i;
+                            isExecuting = true;
+                            break;
+                        }
+                    }
+                }
+            }
+
+            if (isExecuting) {
+                auto it = std::find_if(processes.begin(), processes.end(), [&](const Process& p) {
+                    return p.name == currentProcess.name;
+                });
+                size_t index = std::distance(processes.begin(), it);
+                timeline[index][currentTime] = '*';
+
+                --currentProcess.serviceTime;
+                --remainingQuantum;
+                
+                if (currentProcess.serviceTime == 0 || remainingQuantum == 0) {
+                    for (size_t i = 0; i < readyQueues.size(); ++i) {
+                        if (!readyQueues[i].empty() && readyQueues[i].front().name == currentProcess.name) {
+                            readyQueues[i].pop();
+                            if (remainingQuantum == 0 && currentProcess.serviceTime > 0) {
+                                size_t nextQueueIndex = i + 1;
+                                if (nextQueueIndex >= readyQueues.size()) {
+                                    readyQueues.emplace_back(); 
+                                }
+                                readyQueues[nextQueueIndex].push(currentProcess); 
+                            } else if (currentProcess.serviceTime == 0) {
+                                auto it = std::find_if(processes.begin(), processes.end(), [&](const Process& p) {
+                                    return p.name == currentProcess.name;
+                                });
+                                if (it != processes.end()) {
+                                    it->finishTime = currentTime + 1;
+                                }
+                            }
+                            break;
+                        }
+                    }
+                    isExecuting = false;
+                }
+            }
+            ++currentTime;
+        }
+
+        if (trace) {
+            displayTraceTimeline(traceLabel(), processes, timeline, simulationEnd);
+        }
+    }
+};
+
+// ----------------------------------------
+class Aging : public Policy {
+private:
+    int quantum;
+
+public:
+    void setQuantum(int q) {
+        quantum = q;    
+    }
+
+    std::string traceLabel() const override {
+        return "Aging ";
+    }
+
+    void executeTrace(int simulationEnd, bool trace) {
+        std::queue<Process> readyQueue;
+        std::vector<Process> runningQueue;
+        int currentTime = 0;
+
+        timeline.assign(processes.size(), std::vector<char>(simulationEnd, ' '));
+        std::vector<bool> isInQueue(processes.size(), false);
+
+        while (currentTime < simulationEnd) {
+        for (size_t i = 0; i < processes.size(); ++i) {
+            if (processes[i].arrivalTime <= currentTime && !isInQueue[i]) {
+                readyQueue.push(processes[i]);
+                isInQueue[i] = true;
+            }
+        }
+
+
+        if (!readyQueue.empty()) {
+            Process currentProcess = readyQueue.front();
+            runningQueue.push_back(currentProcess);
+
+            for (size_t i = 0; i < processes.size(); ++i) {
+            if (processes[i].arrivalTime <=  currentTime+quantum && !isInQueue[i]) {
+                readyQueue.push(processes[i]);
+                isInQueue[i] = true;
+            }
+        }
+
+            for (int t = 0; t < quantum; ++t) {
+                std::queue<Process> tempQueue = readyQueue; 
+                while (!tempQueue.empty()) {
+                    Process queuedProcess = tempQueue.front();
+                    tempQueue.pop();
+
+                    auto queuedIt = std::find_if(processes.begin(), processes.end(), [&](const Process& p) {
+                        return p.name == queuedProcess.name;
+                    });
+                    size_t queuedIndex = std::distance(processes.begin(), queuedIt);
+
+                    if (currentTime + t >= processes[queuedIndex].arrivalTime && currentTime + t < simulationEnd) {   
+                        timeline[queuedIndex][currentTime + t] = '.';
+                    }
+                }
+
+                auto it = std::find_if(processes.begin(), processes.end(), [&](const Process& p) {
+                    return p.name == currentProcess.name;
+                });
+                size_t index = std::distance(processes.begin(), it);
+                if (currentTime + t < simulationEnd) {
+                    timeline[index][currentTime + t] = '*';
+                }
+            }
+
+            currentTime += quantum;
+            std::queue<Process> p;
+            
+            while(!readyQueue.empty()) {
+                if(readyQueue.front() == currentProcess) {
+                    readyQueue.front().priority = currentProcess.initialPriority;
+                    p.push(readyQueue.front());
+                    readyQueue.pop();
+                }
+                else  {
+                    readyQueue.front().priority++;
+                    p.push(readyQueue.front());
+                    readyQueue.pop();
+                } 
+            }
+
+            while(!p.empty()) {
+                readyQueue.push(p.front());
+                p.pop();
+            }
+           
+            std::vector<Process> temp;
+            while (!readyQueue.empty()) {
+                temp.push_back(readyQueue.front());
+                readyQueue.pop();
+            }
+
+            std::sort(temp.begin(), temp.end(), [](const Process& a, const Process& b) {
+                return a.priority > b.priority; 
+            });
+
+            int highestPriority = temp[0].priority;
+            int i = 0;
+            std::vector<Process> conflictProcesses;
+            std::vector<Process> solvedProcesses;
+
+            while(i + 1 < (int)temp.size() && temp[i].priority == highestPriority && temp[i].priority == temp[i+1].priority) {
+                conflictProcesses.push_back(temp[i]);
+                i++;
+            }
+            conflictProcesses.push_back(temp[i]);
+            
+            if(conflictProcesses.size() == 2) {
+                if(temp[0].priority == temp[1].priority) {
+                    for (int i = runningQueue.size() - 1; i >= 0; --i) {
+                        if(temp[0] == runningQueue[i]) {
+                            temp.push_back(temp[0]);
+                            temp.erase(temp.begin());
+                            break;
+                        } else if (temp[1] == runningQueue[i]) {
+                            break;
+                        }
+                    }
+                
+                }
+            } else {
+                int j;
+                if(temp.size() > 1 && temp[0].priority == temp[1].priority) {
+                    for (int i = runningQueue.size() - 1; i >= 0; --i) {
+                        for(auto& p1 : conflictProcesses) {
+                            if(p1 == runningQueue[i]) {
+                                j = 0;
+                                for(auto& p2 : solvedProcesses) {
+                                    if(p2.name == p1.name) {
+                                        j++;
+                                        break;
+                                    }
+                                }
+                                if(j == 0)
+                                    solvedProcesses.push_back(p1);
+                            }
+                        }
+                    }
+
+                    j = 0;
+                    for(int i = solvedProcesses.size() - 1; i >= 0; --i) {
+                        temp[j] = solvedProcesses[i];
+                        j++;
+                    }
+                }
+            }
+         
+            for (auto& process : temp) {
+                readyQueue.push(process);
+            }
+
+        } else {
+            ++currentTime;
+        }
+    }
+
+    if (trace) {
+        displayTraceTimeline(traceLabel(), processes, timeline, simulationEnd);
+    }
+    }
+};
+
+
+// ----------------------------------------
+// Run queue with one FIFO per priority level and a bitmap of the non-empty levels, as in the
+// priority arrays of the Linux O(1) scheduler: the highest ready level is one count-leading-zeros
+// away, however many jobs are queued. Priorities are clamped to [0, levels).
+template <typename T>
+class PriorityRunQueue {
+public:
+    static const int levels = priorityLevels;
+
+private:
+    std::deque<T> queues[levels];
+    uint64_t bitmap = 0;
+    size_t count = 0;
+
+public:
+    // Inputs are checked with isValidPriority; the clamp only keeps the bitmap in range.
+    static int levelOf(int priority) {
+        return std::clamp(priority, 0, levels - 1);
+    }
+
+    bool empty() const {
+        return bitmap == 0;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    // Highest non-empty level; the queue must not be empty.
+    int highest() const {
+        return 63 - __builtin_clzll(bitmap);
+    }
+
+    void pushBack(int level, T item) {
+        queues[level].push_back(std::move(item));
+        bitmap |= uint64_t(1) << level;
+        ++count;
+    }
+
+    void pushFront(int level, T item) {
+        queues[level].push_front(std::move(item));
+        bitmap |= uint64_t(1) << level;
+        ++count;
+    }
+
+    T popHighest() {
+        int level = highest();
+        T item = std::move(queues[level].front());
+        queues[level].pop_front();
+        if (queues[level].empty()) {
+            bitmap &= ~(uint64_t(1) << level);
+        }
+        --count;
+        return item;
+    }
+};
+
+// Preemptive priority scheduling over PriorityRunQueue; the priority is the fourth input column.
+// A higher-priority arrival preempts the running process, which goes back to the head of its
+// level with the rest of its slice.
+//   "10"   static priority, FIFO within a level (SCHED_FIFO).
+//   "10-q" static priority, round robin with quantum q within a level (SCHED_RR).
+//   "11-q" O(1): active and expired arrays. A process gets a timeslice of q * (priority + 1)
+//          ticks; once it is used up the process moves to the expired array, and the arrays
+//          swap when the active one runs dry. Its effective priority thus drops below every
+//          process still active, so low priorities cannot starve. "11" is "11-1".
+// A process whose slice ran out is queued behind the arrivals of the same tick.
+class PriorityScheduling : public Policy {
+private:
+    bool epochs;
+    int quantum;
+
+    int timeslice(int level) const {
+        return epochs ? quantum * (level + 1) : quantum;
+    }
+
+public:
+    PriorityScheduling(bool epochs, int quantum) : epochs(epochs), quantum(quantum) {}
+
+    bool prioritized() const override {
+        return true;
+    }
+
+    std::string traceLabel() const override {
+        std::string label = epochs ? "O1-" + std::to_string(quantum) : quantum > 0 ? "PRIO-" + std::to_string(quantum) : "PRIO";
+        label.resize(std::max<size_t>(label.size() + 1, 6), ' ');
+        return label;
+    }
+
+    void executeTrace(int simulationEnd, bool trace) override {
+        const size_t n = processes.size();
+        std::vector<int> remaining(n), sliceLeft(n, 0), level(n);
+        std::vector<bool> admitted(n, false);
+        PriorityRunQueue<size_t> arrays[2];
+        int active = 0;
+        for (size_t i = 0; i < n; ++i) {
+            remaining[i] = processes[i].serviceTime;
+            level[i] = PriorityRunQueue<size_t>::levelOf(processes[i].initialPriority);
+        }
+
+        timeline.assign(n, std::vector<char>(simulationEnd, ' '));
+        size_t current = 0, expired = 0;
+        bool running = false, hasExpired = false;
+        for (int t = 0; t < simulationEnd; ++t) {
+            for (size_t i = 0; i < n; ++i) {
+                if (!admitted[i] && processes[i].arrivalTime <= t) {
+                    admitted[i] = true;
+                    arrays[active].pushBack(level[i], i);
+                }
+            }
+            if (hasExpired) {
+                arrays[epochs ? 1 - active : active].pushBack(level[expired], expired);
+                hasExpired = false;
+            }
+            if (running && !arrays[active].empty() && arrays[active].highest() > level[current]) {
+                arrays[active].pushFront(level[current], current);
+                running = false;
+            }
+            if (!running) {
+                if (arrays[active].empty()) {
+                    active = 1 - active;
+                }
+                if (arrays[active].empty()) {
+                    continue;
+                }
+                current = arrays[active].popHighest();
+                if (sliceLeft[current] == 0) {
+                    sliceLeft[current] = timeslice(level[current]);
+                }
+                running = true;
+            }
+
+            timeline[current][t] = '*';
+            --remaining[current];
+            --sliceLeft[current];
+            if (remaining[current] == 0) {
+                processes[current].finishTime = t + 1;
+                running = false;
+            } else if (quantum > 0 && sliceLeft[current] == 0) {
+                expired = current;
+                hasExpired = true;
+                running = false;
+            }
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            int readyEnd = processes[i].finishTime ? processes[i].finishTime : simulationEnd;
+            for (int t = processes[i].arrivalTime; t < readyEnd; ++t) {
+                if (timeline[i][t] == ' ') timeline[i][t] = '.';
+            }
+        }
+
+        if (trace) {
+            displayTraceTimeline(traceLabel(), processes, timeline, simulationEnd);
+        }
+    }
+};
+
+// ----------------------------------------
+// Event-driven FCFS: orders processes by arrival once and fills each row directly instead of
+// rescanning the ready queue every tick. Only used as a candidate engine by the verifier.
+class FCFSEvent : public Policy {
+public:
+    std::string traceLabel() const override {
+        return "FCFS  ";
+    }
+
+    void executeTrace(int simulationEnd, bool trace) override {
+        timeline.assign(processes.size(), std::vector<char>(simulationEnd, ' '));
+
+        std::vector<size_t> order(processes.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return processes[a].arrivalTime < processes[b].arrivalTime;
+        });
+
+        int cpuFree = 0;
+        for (size_t index : order) {
+            Process& process = processes[index];
+            if (process.arrivalTime >= simulationEnd) {
+                break;
+            }
+
+            int start = std::max(cpuFree, process.arrivalTime);
+            int finish = start + process.serviceTime;
+            std::fill(timeline[index].begin() + process.arrivalTime, timeline[index].begin() + std::min(start, simulationEnd), '.');
+            if (start < simulationEnd) {
+                std::fill(timeline[index].begin() + start, timeline[index].begin() + std::min(finish, simulationEnd), '*');
+            }
+            if (finish <= simulationEnd) {
+                process.finishTime = finish;
+            }
+            cpuFree = finish;
+        }
+
+        if(trace)
+            displayTraceTimeline(traceLabel(), processes, timeline, simulationEnd);
+    }
+};
+
+// ----------------------------------------
+// DVFS model for the online engine: one core with discrete frequency levels (MHz, ascending)
+// and a relative capacity (100 = the core the service times were measured on; a little core
+// might be 50). A governor picks the level at the start of every tick from the recent load.
+// Work is counted in cycles: a job needs serviceTime * fMax * 100, and a tick at frequency f
+// retires f * capacity. A tick costs staticPower, plus (f / fMax)^3 * capacity / 100 while busy,
+// so a busy tick at full speed on the reference core costs 1 + staticPower.
+class SpeedModel {
+public:
+    enum class Governor { Performance, Powersave, Ondemand, Schedutil };
+
+private:
+    static constexpr double staticPower = 0.05;
+    static constexpr double utilDecay = 0.917;  // PELT-like: busy history halves every 8 ticks
+    static constexpr int idleSteps = 64;        // idle ticks simulated one by one before decaying in bulk
+
+    Governor governor = Governor::Performance;
+    std::vector<int> levels = {800, 1600, 2400};
+    int capacity = 100;
+
+    size_t level = 0;
+    double util = 0;
+    uint32_t recentBusy = 0;  // ondemand sampling window: one bit per tick, last 8 ticks
+    int64_t ticks = 0;
+    double frequencySum = 0;
+    double energy = 0, idleEnergy = 0;
+    std::vector<uint8_t>* levelTrace = nullptr;
+    size_t traceLimit = 0;
+
+    size_t lowestLevelAtLeast(double frequency) const {
+        for (size_t i = 0; i < levels.size(); ++i) {
+            if (levels[i] >= frequency) return i;
+        }
+        return levels.size() - 1;
+    }
+
+    void chooseLevel() {
+        switch (governor) {
+            case Governor::Performance: level = levels.size() - 1; break;
+            case Governor::Powersave: level = 0; break;
+            case Governor::Ondemand: {
+                // Like Linux ondemand: jump to the top above 80% load, otherwise scale with it.
+                double load = __builtin_popcount(recentBusy & 0xff) / 8.0;
+                level = load >= 0.8 ? levels.size() - 1 : lowestLevelAtLeast(load * levels.back());
+                break;
+            }
+            case Governor::Schedutil:
+                // Like Linux schedutil: 1.25 * fMax * frequency-invariant utilization.
+                level = lowestLevelAtLeast(1.25 * levels.back() * util);
+                break;
+        }
+    }
+
+    void account(bool busy) {
+        double relative = double(levels[level]) / levels.back();
+        util = util * utilDecay + (busy ? (1 - utilDecay) * relative : 0);
+        recentBusy = (recentBusy << 1) | (busy ? 1 : 0);
+        if (levelTrace && levelTrace->size() < traceLimit) {
+            levelTrace->push_back(static_cast<uint8_t>(level));
+        }
+        ++ticks;
+        frequencySum += levels[level];
+    }
+
+public:
+    // "GOVERNOR[:F1,F2,...][@CAPACITY]", e.g. "ondemand", "schedutil:600,1200,2400@50".
+    bool parse(const std::string& spec) {
+        size_t at = spec.find('@');
+        size_t colon = spec.find(':');
+        std::string name = spec.substr(0, std::min(colon, at));
+        static const std::pair<const char*, Governor> governors[] = {
+            {"performance", Governor::Performance}, {"powersave", Governor::Powersave},
+            {"ondemand", Governor::Ondemand}, {"schedutil", Governor::Schedutil}};
+        bool known = false;
+        for (const auto& g : governors) {
+            if (name == g.first) {
+                governor = g.second;
+                known = true;
+            }
+        }
+        if (!known) {
+            return false;
+        }
+        if (colon != std::string::npos) {
+            levels.clear();
+            std::string list = spec.substr(colon + 1, at == std::string::npos ? std::string::npos : at - colon - 1);
+            size_t begin = 0;
+            while (begin <= list.size()) {
+                size_t comma = std::min(list.find(',', begin), list.size());
+                int frequency = 0;
+                auto parsed = std::from_chars(list.data() + begin, list.data() + comma, frequency);
+                if (parsed.ec != std::errc() || parsed.ptr != list.data() + comma || frequency <= 0 ||
+                    (!levels.empty() && frequency <= levels.back())) {
+                    return false;
+                }
+                levels.push_back(frequency);
+                begin = comma + 1;
+            }
+            if (levels.size() > 10) {
+                return false;
+            }
+        }
+        if (at != std::string::npos) {
+            auto parsed = std::from_chars(spec.data() + at + 1, spec.data() + spec.size(), capacity);
+            if (parsed.ec != std::errc() || parsed.ptr != spec.data() + spec.size() || capacity <= 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void reset() {
+        level = 0;
+        util = 0;
+        recentBusy = 0;
+        ticks = 0;
+        frequencySum = 0;
+        energy = idleEnergy = 0;
+    }
+
+    // Records the level of every tick into trace, up to limit ticks.
+    void traceLevels(std::vector<uint8_t>* trace, size_t limit) {
+        levelTrace = trace;
+        traceLimit = limit;
+    }
+
+    int64_t cyclesPerServiceUnit() const {
+        return int64_t(levels.back()) * 100;
+    }
+
+    // Runs one busy tick: picks the level, charges its energy to jobEnergy, returns the cycles retired.
+    int64_t busyTick(double& jobEnergy) {
+        chooseLevel();
+        double relative = double(levels[level]) / levels.back();
+        double cost = relative * relative * relative * capacity / 100;
+        jobEnergy += cost;
+        energy += cost + staticPower;
+        idleEnergy += staticPower;
+        account(true);
+        return int64_t(levels[level]) * capacity;
+    }
+
+    void idleTicks(int64_t count) {
+        int64_t stepped = std::min<int64_t>(count, idleSteps);
+        for (int64_t i = 0; i < stepped; ++i) {
+            chooseLevel();
+            account(false);
+        }
+        int64_t rest = count - stepped;
+        if (rest > 0) {
+            util *= std::pow(utilDecay, double(rest));
+            recentBusy = 0;
+            chooseLevel();
+            if (levelTrace && levelTrace->size() < traceLimit) {
+                levelTrace->resize(std::min<size_t>(traceLimit, levelTrace->size() + rest), static_cast<uint8_t>(level));
+            }
+            ticks += rest;
+            frequencySum += double(levels[level]) * rest;
+        }
+        energy += staticPower * count;
+        idleEnergy += staticPower * count;
+    }
+
+    double totalEnergy() const { return energy; }
+    // Static power over every simulated tick, busy or idle.
+    double staticEnergy() const { return idleEnergy; }
+    double meanFrequency() const { return ticks ? frequencySum / ticks : 0; }
+};
+
+// ----------------------------------------
+// Online engine: runs a policy over an open stream of arrivals and retires jobs as they finish,
+// so memory follows the number of jobs in the system rather than the length of the run. It
+// follows the tie-breaks of the reference policies for arrivals in non-decreasing order:
+// SPN/SRT prefer the earlier arrival among equal times, HRRN keeps the first of equal ratios,
+// RR enqueues arrivals of the whole quantum ahead of the preempted process, and FB keeps a
+// lone process on level 0.
+struct OnlineJob {
+    uint64_t seq = 0;
+    std::string name;
+    int64_t arrival = 0;
+    int64_t service = 0;
+    int64_t remaining = 0;  // ticks, or cycles under a SpeedModel
+    int level = 0;
+    double energy = 0;      // dynamic energy charged so far under a SpeedModel
+    int priority = 0;       // priority policies only, higher runs first
+    int64_t slice = 0;      // ticks left of the current timeslice; 0 until first dispatched
+    bool timeBound = false; // carries no work, only the promise that nothing arrives before `arrival`
+};
+
+class ArrivalSource {
+public:
+    virtual ~ArrivalSource() = default;
+    // Next job in non-decreasing arrival order; false once the source is exhausted.
+    virtual bool next(OnlineJob& job) = 0;
+};
+
+class OnlineObserver {
+public:
+    virtual ~OnlineObserver() = default;
+    virtual void onArrival(const OnlineJob&) {}
+    // job ran on the CPU for [start, end).
+    virtual void onSlice(const OnlineJob&, int64_t, int64_t) {}
+    virtual void onFinish(const OnlineJob&, int64_t) {}
+    // During [from, to) `waiting` jobs had arrived and were not running; busy if one was.
+    virtual void onInterval(int64_t, int64_t, size_t, bool) {}
+};
+
+class OnlineScheduler {
+public:
+    enum class Kind { FCFS, RR, SPN, SRT, HRRN, FB1, FB2i, Priority, O1 };
+
+private:
+    Kind kind = Kind::FCFS;
+    int quantum = 1;
+    bool valid = false;
+
+    ArrivalSource* source = nullptr;
+    OnlineObserver* observer = nullptr;
+    SpeedModel* speed = nullptr;
+    OnlineJob lookahead;
+    bool hasLookahead = false;
+    uint64_t arrivedCount = 0;
+
+    bool sliceOpen = false;
+    OnlineJob sliceJob;
+    int64_t sliceStart = 0, sliceEnd = 0;
+
+    struct LaterFirst {
+        bool (*less)(const OnlineJob&, const OnlineJob&);
+        bool operator()(const OnlineJob& a, const OnlineJob& b) const { return less(b, a); }
+    };
+    using JobHeap = std::priority_queue<OnlineJob, std::vector<OnlineJob>, LaterFirst>;
+
+    static bool shorterService(const OnlineJob& a, const OnlineJob& b) {
+        if (a.service != b.service) return a.service < b.service;
+        return a.seq < b.seq;
+    }
+
+    static bool shorterRemaining(const OnlineJob& a, const OnlineJob& b) {
+        if (a.remaining != b.remaining) return a.remaining < b.remaining;
+        return a.seq < b.seq;
+    }
+
+    void fetch() {
+        hasLookahead = source->next(lookahead);
+        if (hasLookahead) {
+            lookahead.seq = arrivedCount + 1;
+            lookahead.remaining = lookahead.service * (speed ? speed->cyclesPerServiceUnit() : 1);
+            lookahead.level = 0;
+            lookahead.energy = 0;
+            lookahead.slice = 0;
+        }
+    }
+
+    // Moves every job that has arrived by time t into the policy's ready structure.
+    template <typename Enqueue>
+    void admit(int64_t t, Enqueue enqueue) {
+        while (hasLookahead && lookahead.arrival <= t) {
+            if (!lookahead.timeBound) {
+                ++arrivedCount;
+                observer->onArrival(lookahead);
+                enqueue(lookahead);
+            }
+            fetch();
+        }
+    }
+
+    void runTick(const OnlineJob& job, int64_t t, size_t waiting) {
+        if (sliceOpen && (sliceJob.seq != job.seq || sliceEnd != t)) {
+            closeSlice();
+        }
+        if (!sliceOpen) {
+            sliceOpen = true;
+            sliceJob = job;
+            sliceStart = t;
+        }
+        sliceEnd = t + 1;
+        observer->onInterval(t, t + 1, waiting, true);
+    }
+
+    // Retires one tick of work from job; true once it is done.
+    bool advance(OnlineJob& job) {
+        job.remaining -= speed ? speed->busyTick(job.energy) : 1;
+        return job.remaining <= 0;
+    }
+
+    // Runs job for up to limit ticks and returns how many it used.
+    int64_t runFor(OnlineJob& job, int64_t limit) {
+        if (!speed) {
+            int64_t used = std::min(limit, job.remaining);
+            job.remaining -= used;
+            return used;
+        }
+        int64_t used = 0;
+        while (used < limit && !advance(job)) {
+            ++used;
+        }
+        return used < limit ? used + 1 : used;
+    }
+
+    void closeSlice() {
+        if (sliceOpen) {
+            observer->onSlice(sliceJob, sliceStart, sliceEnd);
+            sliceOpen = false;
+        }
+    }
+
+    void finish(const OnlineJob& job, int64_t time) {
+        closeSlice();
+        observer->onFinish(job, time);
+    }
+
+    // Skips an idle CPU forward to the next arrival; false when nothing is left to simulate.
+    bool idleUntilArrival(int64_t& t, int64_t horizon) {
+        closeSlice();
+        if (!hasLookahead) {
+            return false;
+        }
+        int64_t next = std::min(std::max(lookahead.arrival, t + 1), horizon);
+        if (speed) speed->idleTicks(next - t);
+        observer->onInterval(t, next, 0, false);
+        t = next;
+        return true;
+    }
+
+    void runFCFS(int64_t horizon) {
+        std::deque<OnlineJob> queue;
+        for (int64_t t = 0; t < horizon;) {
+            admit(t, [&](const OnlineJob& job) { queue.push_back(job); });
+            if (queue.empty()) {
+                if (!idleUntilArrival(t, horizon)) break;
+                continue;
+            }
+            OnlineJob& job = queue.front();
+            runTick(job, t, queue.size() - 1);
+            ++t;
+            if (advance(job)) {
+                finish(job, t);
+                queue.pop_front();
+            }
+        }
+    }
+
+    void runRoundRobin(int64_t horizon) {
+        std::deque<OnlineJob> queue;
+        std::deque<int64_t> futureArrivals;  // arrival times of queued jobs that have not arrived yet
+        OnlineJob preempted;
+        bool hasPreempted = false;
+        auto enqueue = [&](const OnlineJob& job) { queue.push_back(job); };
+
+        for (int64_t t = 0; t < horizon;) {
+            admit(t, enqueue);
+            if (hasPreempted) {
+                queue.push_back(preempted);
+                hasPreempted = false;
+            }
+            if (queue.empty()) {
+                if (!idleUntilArrival(t, horizon)) break;
+                continue;
+            }
+
+            OnlineJob job = queue.front();
+            queue.pop_front();
+            int64_t executionTime = runFor(job, quantum);
+            admit(t + executionTime, [&](const OnlineJob& arrival) {
+                queue.push_back(arrival);
+                if (arrival.arrival > t) futureArrivals.push_back(arrival.arrival);
+            });
+
+            for (int64_t tick = t; tick < t + executionTime; ++tick) {
+                while (!futureArrivals.empty() && futureArrivals.front() <= tick) {
+                    futureArrivals.pop_front();
+                }
+                if (tick < horizon) {
+                    runTick(job, tick, queue.size() - futureArrivals.size());
+                }
+            }
+            futureArrivals.clear();
+            t += executionTime;
+
+            if (job.remaining > 0) {
+                preempted = job;
+                hasPreempted = true;
+            } else {
+                finish(job, t);
+            }
+        }
+        closeSlice();
+    }
+
+    void runSPN(int64_t horizon) {
+        JobHeap ready(LaterFirst{shorterService});
+        OnlineJob current;
+        bool running = false;
+        for (int64_t t = 0; t < horizon;) {
+            admit(t, [&](const OnlineJob& job) { ready.push(job); });
+            if (!running) {
+                if (ready.empty()) {
+                    if (!idleUntilArrival(t, horizon)) break;
+                    continue;
+                }
+                current = ready.top();
+                ready.pop();
+                running = true;
+            }
+            runTick(current, t, ready.size());
+            ++t;
+            if (advance(current)) {
+                finish(current, t);
+                running = false;
+            }
+        }
+    }
+
+    void runSRT(int64_t horizon) {
+        JobHeap ready(LaterFirst{shorterRemaining});
+        for (int64_t t = 0; t < horizon;) {
+            admit(t, [&](const OnlineJob& job) { ready.push(job); });
+            if (ready.empty()) {
+                if (!idleUntilArrival(t, horizon)) break;
+                continue;
+            }
+            OnlineJob current = ready.top();
+            ready.pop();
+            runTick(current, t, ready.size());
+            ++t;
+            if (advance(current)) {
+                finish(current, t);
+            } else {
+                ready.push(current);
+            }
+        }
+    }
+
+    void runHRRN(int64_t horizon) {
+        std::vector<OnlineJob> ready;
+        OnlineJob current;
+        bool running = false;
+        for (int64_t t = 0; t < horizon;) {
+            admit(t, [&](const OnlineJob& job) { ready.push_back(job); });
+            if (!running) {
+                if (ready.empty()) {
+                    if (!idleUntilArrival(t, horizon)) break;
+                    continue;
+                }
+                // Same float arithmetic as HRRN so equal ratios tie the same way.
+                float maxRR = -1.0;
+                size_t selectedIndex = 0;
+                for (size_t i = 0; i < ready.size(); ++i) {
+                    int64_t waitingTime = t - ready[i].arrival;
+                    float responseRatio = (waitingTime + ready[i].service) / float(ready[i].service);
+                    if (responseRatio > maxRR) {
+                        maxRR = responseRatio;
+                        selectedIndex = i;
+                    }
+                }
+                current = ready[selectedIndex];
+                ready.erase(ready.begin() + selectedIndex);
+                running = true;
+            }
+            runTick(current, t, ready.size());
+            ++t;
+            if (advance(current)) {
+                finish(current, t);
+                running = false;
+            }
+        }
+    }
+
+    void runFeedback(int64_t horizon) {
+        // Only occupied levels are kept: under FB-1 a long job descends one level per tick.
+        std::map<size_t, std::deque<OnlineJob>> levels;
+        size_t waiting = 0;
+        OnlineJob current;
+        int64_t remainingQuantum = 0;
+        bool running = false;
+
+        for (int64_t t = 0; t < horizon;) {
+            admit(t, [&](const OnlineJob& job) {
+                levels[0].push_back(job);
+                ++waiting;
+            });
+
+            if (!running) {
+                if (levels.empty()) {
+                    if (!idleUntilArrival(t, horizon)) break;
+                    continue;
+                }
+                auto top = levels.begin();
+                current = top->second.front();
+                top->second.pop_front();
+                if (top->first == 1 && arrivedCount == 1) {
+                    current.level = 0;
+                }
+                remainingQuantum = kind == Kind::FB1 ? 1 : int64_t(1) << std::min<size_t>(current.level, 62);
+                if (top->second.empty()) levels.erase(top);
+                running = true;
+                --waiting;
+            }
+
+            runTick(current, t, waiting);
+            ++t;
+            bool done = advance(current);
+            --remainingQuantum;
+            if (done) {
+                finish(current, t);
+                running = false;
+            } else if (remainingQuantum == 0) {
+                ++current.level;
+                levels[current.level].push_back(current);
+                ++waiting;
+                running = false;
+            }
+        }
+        closeSlice();
+    }
+
+    // Same rules as PriorityScheduling: static levels ("10", "10-q") or O(1) active and expired
+    // arrays ("11-q"), preempted jobs back at the head of their level.
+    void runPriority(int64_t horizon) {
+        using RunQueue = PriorityRunQueue<OnlineJob>;
+        RunQueue arrays[2];
+        int active = 0;
+        OnlineJob current, expired;
+        bool running = false, hasExpired = false;
+        const bool epochs = kind == Kind::O1;
+        auto waiting = [&]() { return arrays[0].size() + arrays[1].size(); };
+
+        for (int64_t t = 0; t < horizon;) {
+            admit(t, [&](const OnlineJob& job) { arrays[active].pushBack(RunQueue::levelOf(job.priority), job); });
+            if (hasExpired) {
+                arrays[epochs ? 1 - active : active].pushBack(RunQueue::levelOf(expired.priority), expired);
+                hasExpired = false;
+            }
+            if (running && !arrays[active].empty() && arrays[active].highest() > RunQueue::levelOf(current.priority)) {
+                arrays[active].pushFront(RunQueue::levelOf(current.priority), current);
+                running = false;
+            }
+            if (!running) {
+                if (arrays[active].empty()) {
+                    active = 1 - active;
+                }
+                if (arrays[active].empty()) {
+                    if (!idleUntilArrival(t, horizon)) break;
+                    continue;
+                }
+                current = arrays[active].popHighest();
+                if (current.slice == 0) {
+                    current.slice = epochs ? int64_t(quantum) * (RunQueue::levelOf(current.priority) + 1) : quantum;
+                }
+                running = true;
+            }
+
+            runTick(current, t, waiting());
+            ++t;
+            --current.slice;
+            if (advance(current)) {
+                finish(current, t);
+                running = false;
+            } else if (quantum > 0 && current.slice == 0) {
+                expired = current;
+                hasExpired = true;
+                running = false;
+            }
+        }
+        closeSlice();
+    }
+
+public:
+    // Accepts the policy specs of the reference policies except Aging: "1", "2-q", "3" ... "7",
+    // "10", "10-q" and "11-q".
+    explicit OnlineScheduler(const std::string& policy) {
+        size_t dash = policy.find('-');
+        std::string id = policy.substr(0, dash);
+        if (dash != std::string::npos) {
+            quantum = std::atoi(policy.c_str() + dash + 1);
+        } else if (id == "10") {
+            quantum = 0;
+        }
+        static const std::pair<const char*, Kind> kinds[] = {
+            {"1", Kind::FCFS}, {"2", Kind::RR}, {"3", Kind::SPN}, {"4", Kind::SRT},
+            {"5", Kind::HRRN}, {"6", Kind::FB1}, {"7", Kind::FB2i}, {"10", Kind::Priority}, {"11", Kind::O1}};
+        for (const auto& k : kinds) {
+            if (id == k.first) {
+                kind = k.second;
+                valid = kind == Kind::Priority ? quantum >= 0 : (kind != Kind::RR && kind != Kind::O1) || quantum > 0;
+            }
+        }
+    }
+
+    bool isValid() const {
+        return valid;
+    }
+
+    // Runs under a speed model: jobs progress by the cycles of each tick instead of one unit.
+    void setSpeedModel(SpeedModel* model) {
+        speed = model;
+    }
+
+    // Simulates until the source is exhausted and every job has finished, or until horizon.
+    void run(ArrivalSource& arrivals, OnlineObserver& events, int64_t horizon = INT64_MAX) {
+        source = &arrivals;
+        observer = &events;
+        arrivedCount = 0;
+        sliceOpen = false;
+        fetch();
+        switch (kind) {
+            case Kind::FCFS: runFCFS(horizon); break;
+            case Kind::RR: runRoundRobin(horizon); break;
+            case Kind::SPN: runSPN(horizon); break;
+            case Kind::SRT: runSRT(horizon); break;
+            case Kind::HRRN: runHRRN(horizon); break;
+            case Kind::FB1:
+            case Kind::FB2i: runFeedback(horizon); break;
+            case Kind::Priority:
+            case Kind::O1: runPriority(horizon); break;
+        }
+        closeSlice();
+    }
+};
+
+// Replays a fixed process list; processes must be given in non-decreasing arrival order.
+class ProcessArrivalSource : public ArrivalSource {
+private:
+    const std::vector<Process>& processes;
+    size_t nextIndex = 0;
+
+public:
+    explicit ProcessArrivalSource(const std::vector<Process>& processes) : processes(processes) {}
+
+    bool next(OnlineJob& job) override {
+        if (nextIndex == processes.size()) {
+            return false;
+        }
+        const Process& p = processes[nextIndex++];
+        job.name = std::string(1, p.name);
+        job.arrival = p.arrivalTime;
+        job.service = p.serviceTime;
+        job.priority = p.initialPriority;
+        return true;
+    }
+};
+
+// Runs the online engine behind the Policy interface, so the verifier can compare it with the
+// reference policies and --dvfs can run them under a SpeedModel. The engine sees the processes
+// stably sorted by arrival.
+class OnlinePolicy : public Policy, private OnlineObserver {
+private:
+    std::string spec;
+    std::string label;
+    int horizon = 0;
+    std::vector<size_t> order;  // engine sequence number - 1 -> index in processes
+    bool scaled = false;
+    SpeedModel speed;
+
+    void onSlice(const OnlineJob& job, int64_t start, int64_t end) override {
+        std::vector<char>& row = timeline[order[job.seq - 1]];
+        std::fill(row.begin() + start, row.begin() + std::min<int64_t>(end, horizon), '*');
+    }
+
+    void onFinish(const OnlineJob& job, int64_t time) override {
+        size_t index = order[job.seq - 1];
+        processes[index].finishTime = static_cast<int>(time);
+        if (scaled) energy.perProcess[index] = job.energy;
+    }
+
+public:
+    explicit OnlinePolicy(const std::string& spec, const std::string& label = "Online") : spec(spec), label(label) {}
+
+    void setSpeedModel(const SpeedModel& model) {
+        speed = model;
+        scaled = true;
+    }
+
+    std::string traceLabel() const override {
+        return label;
+    }
+
+    bool prioritized() const override {
+        return isPriorityPolicy(spec);
+    }
+
+    void executeTrace(int simulationEnd, bool trace) override {
+        horizon = simulationEnd;
+        timeline.assign(processes.size(), std::vector<char>(simulationEnd, ' '));
+        order.resize(processes.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return processes[a].arrivalTime < processes[b].arrivalTime;
+        });
+        std::vector<Process> arrivals;
+        for (size_t index : order) arrivals.push_back(processes[index]);
+
+        OnlineScheduler scheduler(spec);
+        energy = EnergyReport();
+        if (scaled) {
+            speed.reset();
+            speed.traceLevels(&energy.levels, simulationEnd);
+            energy.perProcess.assign(processes.size(), 0);
+            scheduler.setSpeedModel(&speed);
+        }
+        ProcessArrivalSource source(arrivals);
+        scheduler.run(source, *this, simulationEnd);
+        if (scaled) {
+            energy.total = speed.totalEnergy();
+            energy.staticEnergy = speed.staticEnergy();
+            energy.meanFrequency = speed.meanFrequency();
+            speed.traceLevels(nullptr, 0);
+        }
+
+        for (size_t i = 0; i < processes.size(); ++i) {
+            int readyEnd = processes[i].finishTime ? std::min(processes[i].finishTime, simulationEnd) : simulationEnd;
+            for (int t = processes[i].arrivalTime; t < readyEnd; ++t) {
+                if (timeline[i][t] == ' ') timeline[i][t] = '.';
+            }
+        }
+
+        if (trace)
+            displayTraceTimeline(traceLabel(), processes, timeline, simulationEnd);
+    }
+};
+
+// ----------------------------------------
+// Fluid engine: the limits of the time-slicing policies as the quantum goes to zero, for
+// workloads too large to simulate slice by slice. Processor sharing (RR) serves every job in the
+// system at rate 1/n; least attained service (FB) shares the CPU among the jobs that have
+// received the least service so far. Time advances from event to event (arrival, completion,
+// or under LAS one group catching up with the next) in closed form, so the cost is per event
+// and not per tick.
+//
+// Jobs are handled in classes: count identical jobs (same arrival and service) are one weighted
+// entry that finishes all at once, so a workload of many repeated job shapes costs as much as
+// its number of distinct shapes.
+enum class FluidDiscipline { ProcessorSharing, LeastAttained };
+
+struct FluidClass {
+    int64_t arrival = 0;
+    int64_t service = 0;
+    uint64_t count = 0;
+};
+
+class FluidObserver {
+public:
+    virtual ~FluidObserver() = default;
+    virtual void onFinish(const FluidClass&, double) {}
+};
+
+class FluidScheduler {
+private:
+    // A class waiting for the fluid level to reach `key`: its virtual finish time under PS, its
+    // service under LAS. Heaps are ordered with the smallest key on top.
+    struct Entry {
+        double key;
+        FluidClass jobs;
+        bool operator>(const Entry& other) const { return key > other.key; }
+    };
+    using Heap = std::vector<Entry>;
+
+    // Jobs at the same attained service level; they stay together until they finish.
+    struct Group {
+        uint64_t weight = 0;
+        Heap members;
+    };
+
+    FluidDiscipline discipline;
+    FluidObserver& observer;
+    double now = 0;
+    size_t classCount = 0;
+
+    // PS: virtual time advances at 1 / (jobs in the system); a job finishes when it has grown
+    // by the job's service since its arrival.
+    double virtualTime = 0;
+    uint64_t weight = 0;
+    Heap pending;
+
+    // LAS: the group with the least attained service runs; higher groups wait, keyed by level.
+    double level = 0;
+    Group running;
+    std::map<double, Group> waiting;
+
+    static void push(Heap& heap, Entry entry) {
+        heap.push_back(std::move(entry));
+        std::push_heap(heap.begin(), heap.end(), std::greater<Entry>());
+    }
+
+    static Entry pop(Heap& heap) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<Entry>());
+        Entry entry = std::move(heap.back());
+        heap.pop_back();
+        return entry;
+    }
+
+    static void merge(Group& into, Group& from) {
+        if (into.members.size() < from.members.size()) {
+            std::swap(into.members, from.members);
+        }
+        for (Entry& entry : from.members) {
+            push(into.members, std::move(entry));
+        }
+        into.weight += from.weight;
+        from = Group();
+    }
+
+    void finish(Heap& heap, uint64_t& jobs) {
+        Entry entry = pop(heap);
+        jobs -= entry.jobs.count;
+        observer.onFinish(entry.jobs, now);
+    }
+
+    void advanceSharing(double until) {
+        while (weight > 0) {
+            double finishAt = now + (pending.front().key - virtualTime) * double(weight);
+            if (finishAt > until) {
+                virtualTime += (until - now) / double(weight);
+                break;
+            }
+            now = finishAt;
+            virtualTime = pending.front().key;
+            finish(pending, weight);
+        }
+    }
+
+    void advanceLeastAttained(double until) {
+        while (true) {
+            if (running.weight == 0) {
+                if (waiting.empty()) {
+                    break;
+                }
+                level = waiting.begin()->first;
+                running = std::move(waiting.begin()->second);
+                waiting.erase(waiting.begin());
+            }
+            double target = running.members.front().key;
+            if (!waiting.empty()) {
+                target = std::min(target, waiting.begin()->first);
+            }
+            double reachAt = now + (target - level) * double(running.weight);
+            if (reachAt > until) {
+                level += (until - now) / double(running.weight);
+                break;
+            }
+            now = reachAt;
+            level = target;
+            while (running.weight > 0 && running.members.front().key <= level) {
+                finish(running.members, running.weight);
+            }
+            if (!waiting.empty() && waiting.begin()->first <= level) {
+                merge(running, waiting.begin()->second);
+                waiting.erase(waiting.begin());
+            }
+        }
+    }
+
+    void advance(double until) {
+        if (discipline == FluidDiscipline::ProcessorSharing) {
+            advanceSharing(until);
+        } else {
+            advanceLeastAttained(until);
+        }
+        if (std::isfinite(until)) {
+            now = std::max(now, until);
+        }
+    }
+
+public:
+    FluidScheduler(FluidDiscipline discipline, FluidObserver& observer) : discipline(discipline), observer(observer) {}
+
+    // Adds count jobs arriving at `arrival`; arrivals must come in non-decreasing order.
+    void arrive(const FluidClass& jobs) {
+        advance(double(jobs.arrival));
+        ++classCount;
+        if (discipline == FluidDiscipline::ProcessorSharing) {
+            push(pending, Entry{virtualTime + double(jobs.service), jobs});
+            weight += jobs.count;
+            return;
+        }
+        // Newcomers have attained nothing, so they preempt the running group.
+        if (running.weight > 0 && level > 0) {
+            merge(waiting[level], running);
+        }
+        level = 0;
+        push(running.members, Entry{double(jobs.service), jobs});
+        running.weight += jobs.count;
+    }
+
+    // Runs until every job has finished and returns the time the last one did.
+    double drain() {
+        advance(std::numeric_limits<double>::infinity());
+        return now;
+    }
+
+    size_t classes() const {
+        return classCount;
+    }
+};
+
+// ----------------------------------------
+// Cell states of a policy timeline as named in every output format.
+inline const char* stateName(char cell) {
+    return cell == '*' ? "running" : "ready";
+}
+
+// Calls callback(start, end, cell) for every maximal run of '*' or '.' cells in a timeline row.
+template <typename Callback>
+void forEachInterval(const std::vector<char>& row, Callback callback) {
+    size_t t = 0;
+    while (t < row.size()) {
+        if (row[t] != '*' && row[t] != '.') {
+            ++t;
+            continue;
+        }
+        size_t start = t;
+        while (t < row.size() && row[t] == row[start]) {
+            ++t;
+        }
+        callback(static_cast<int>(start), static_cast<int>(t), row[start]);
+    }
+}
+
+// Builds the reference policy for a spec such as "1", "2-3" or "8-1"; nullptr if unknown.
+std::unique_ptr<Policy> createPolicy(const std::string& policy, std::string& name);
+
+// Runs one policy spec over the processes until simulationEnd; false if the spec is unknown.
+bool simulate(const std::vector<Process>& processes, const std::string& policy, int simulationEnd, SimulationResult& result);
+
+// Part of every ResultCache key, so results cached by an older binary are never served. The
+// Makefile defines ENGINE_VERSION as a checksum of scheduler.h and scheduler.cpp; a build without
+// it shares version 0 with every other such build.
+#ifndef ENGINE_VERSION
+#define ENGINE_VERSION 0
+#endif
+constexpr uint32_t engineVersion = ENGINE_VERSION;
+
+// Content-addressed cache of simulation results, keyed by the engine version, the normalized
+// policy spec, the horizon and the processes in input order. Entries live in memory (up to
+// capacityBytes, counted mostly by their timelines; oldest evicted first) and, when a directory
+// is given, in one file per key named by its hash; every entry also stores its full key, so a
+// hash collision is a miss. Thread-safe.
+class ResultCache {
+public:
+    explicit ResultCache(std::string directory = "", size_t capacityBytes = size_t(256) << 20);
+
+    bool lookup(const std::vector<Process>& processes, const std::string& policy, int simulationEnd, SimulationResult& result);
+    void store(const std::vector<Process>& processes, const std::string& policy, int simulationEnd, const SimulationResult& result);
+
+    // simulate() that is answered from the cache when the same run was seen before.
+    bool simulate(const std::vector<Process>& processes, const std::string& policy, int simulationEnd, SimulationResult& result);
+
+    size_t hits() const { return hitCount; }
+    size_t misses() const { return missCount; }
+
+private:
+    std::string directory;
+    size_t capacityBytes;
+    size_t bytes = 0;
+    std::mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<const SimulationResult>> entries;
+    std::deque<std::pair<std::string, size_t>> insertionOrder;  // key and its size in bytes
+    std::atomic<size_t> hitCount{0};
+    std::atomic<size_t> missCount{0};
+
+    void remember(const std::string& key, std::shared_ptr<const SimulationResult> result);
+    std::string pathFor(const std::string& key) const;
+};
+
+#endif